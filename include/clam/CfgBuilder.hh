@@ -84,6 +84,11 @@ public:
   const basic_block_label_t *
   getCrabBasicBlock(const llvm::BasicBlock *src,
                     const llvm::BasicBlock *dst) const;
+  // If the incoming edge of bb is not translated to a crab basic
+  // block (see CrabBuilderParams::fold_edge_blocks) then return the
+  // number of statements at the beginning of the crab block of bb
+  // that model the edge. Otherwise, return 0.
+  unsigned getNumFoldedEdgeStatements(const llvm::BasicBlock *bb) const;
   // map a llvm Value to a Crab variable if possible
   llvm::Optional<var_t> getCrabVariable(const llvm::Value &v);
   // map the memory region to which v points to into a Crab region
@@ -97,9 +102,10 @@ public:
   // is always possible to find the corresponding LLVM
   // instruction. Array crab operations are an exceptions.
   //
-  // This method maps an **array** crab statement to its
-  // corresponding llvm instruction. Return null if the the array
-  // instruction is not mapped to a LLVM instruction.
+  // This method maps an **array** or **assertion** crab statement to
+  // its corresponding llvm instruction. Return null if the statement
+  // is not mapped to a LLVM instruction (always if the CFG is
+  // simplified).
   const llvm::Instruction *getInstruction(const statement_t &s) const;
 
 }; // end class CfgBuilder
@@ -125,12 +131,21 @@ public:
 
   CfgBuilderPtr mkCfgBuilder(const llvm::Function &func);
 
+  // Return false if f has no crab CFG or it was released
   bool hasCfg(const llvm::Function &f) const;
 
   cfg_t &getCfg(const llvm::Function &f) const;
 
   CfgBuilderPtr getCfgBuilder(const llvm::Function &f) const;
 
+  // Discard the crab CFG of f so that it is translated again from the
+  // current LLVM code next time it is requested.
+  void resetCfgBuilder(const llvm::Function &f);
+
+  // Free the crab CFG of f but keep its declaration so that the CFGs
+  // of its callers can still be built.
+  void releaseCfgBuilder(const llvm::Function &f);
+
   variable_factory_t &getVarFactory();
 
   const CrabBuilderParams &getCfgBuilderParams() const;
@@ -25,6 +25,17 @@ struct CrabBuilderParams {
   // Translate bignums (> 64), otherwise operations with big numbers
   // are havoced.
   bool enable_bignums;
+  // Translate the PHI nodes of a block as a sequence of copies with
+  // the minimal number of temporaries and without self-copies.
+  bool minimize_phi_copies;
+  // Do not create a block for an edge whose destination has a single
+  // predecessor. The branch condition and PHI assignments are added
+  // at the beginning of the destination block.
+  bool fold_edge_blocks;
+  // Constant integer tables of global initializers with more elements
+  // are initialized only with their smallest and largest elements. 0
+  // means no limit.
+  unsigned max_global_init_table_size;
   /// Add reasonable assumptions about pointers (e.g., allocas and
   /// globals cannot be null, external functions do not return
   /// dangling pointers, etc.)
@@ -42,6 +53,8 @@ struct CrabBuilderParams {
       : precision_level(CrabBuilderPrecision::NUM), simplify(false),
         interprocedural(true), lower_singleton_aliases(false),
         include_useless_havoc(true), enable_bignums(false),
+        minimize_phi_copies(false), fold_edge_blocks(false),
+        max_global_init_table_size(0),
         add_pointer_assumptions(true),
 	check_only_typed_regions(false), check_only_noncyclic_regions(false),
 	print_cfg(false), dot_cfg(false) {}
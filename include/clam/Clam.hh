@@ -11,13 +11,24 @@
 #include "crab/domains/generic_abstract_domain.hpp"
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Pass.h"
 
+#include <functional>
 #include <memory>
 
 // forward declarations
+namespace llvm {
+class TargetLibraryInfoWrapperPass;
+} // namespace llvm
+
 namespace clam {
+class ClamQueryCache;
+class HeapAbstraction;
+class IntraClam;
 class IntraClamImpl;
 class IntraGlobalClamImpl;
 class InterGlobalClamImpl;
@@ -34,6 +45,8 @@ class ClamGlobalAnalysis: public ClamQueryAPI {
 public:
   using abs_dom_map_t =
       llvm::DenseMap<const llvm::BasicBlock *, clam_abstract_domain>;
+  using stmt_abs_dom_map_t =
+      llvm::DenseMap<const llvm::Instruction *, clam_abstract_domain>;
   using lin_csts_map_t =
       llvm::DenseMap<const llvm::BasicBlock *, lin_cst_sys_t>;  
   using checks_db_t = crab::checker::checks_db;
@@ -66,6 +79,13 @@ public:
    **/
   virtual llvm::Optional<clam_abstract_domain> getPost(const llvm::BasicBlock *b,
 						       bool keep_shadows) const = 0;
+
+  /**
+   * Return invariants that hold after I if they were stored during
+   * the analysis (see AnalysisParams::store_stmt_invariants)
+   **/
+  virtual llvm::Optional<clam_abstract_domain>
+  getPostStmt(const llvm::Instruction *I, bool keep_shadows) const = 0;
   
   /**
    * Return a database with all checks.
@@ -110,9 +130,12 @@ public:
   using typename ClamGlobalAnalysis::abs_dom_map_t;
   using typename ClamGlobalAnalysis::lin_csts_map_t;
   using typename ClamGlobalAnalysis::checks_db_t;
+  using analyzed_function_fn_t =
+    std::function<void(const llvm::Function &, IntraGlobalClam &)>;
 
 private:
   std::unique_ptr<IntraGlobalClamImpl> m_impl;  
+  analyzed_function_fn_t m_analyzed_fn;
 
 public:
   
@@ -133,6 +156,14 @@ public:
    **/
   void analyze(AnalysisParams &params, const abs_dom_map_t &assumptions) override;
 
+  /**
+   * Call fn after each function has been analyzed. The results of
+   * the function can be queried from fn. This is the only way of
+   * consuming them if AnalysisParams::stream_functions is enabled
+   * because they are released after fn returns.
+   **/
+  void setAnalyzedFunctionCallback(analyzed_function_fn_t fn);
+
   /**
    * Return invariants that hold at the entry of b
    **/
@@ -145,6 +176,12 @@ public:
   llvm::Optional<clam_abstract_domain> getPost(const llvm::BasicBlock *b,
                                                bool keep_shadows = false) const override;
 
+  /**
+   * Return invariants that hold after I if they were stored
+   **/
+  llvm::Optional<clam_abstract_domain>
+  getPostStmt(const llvm::Instruction *I, bool keep_shadows = false) const override;
+
   /**
    * Return a database with all checks.
    **/
@@ -220,6 +257,12 @@ public:
   llvm::Optional<clam_abstract_domain> getPost(const llvm::BasicBlock *b,
                                                bool keep_shadows = false) const override;
 
+  /**
+   * Return invariants that hold after I if they were stored
+   **/
+  llvm::Optional<clam_abstract_domain>
+  getPostStmt(const llvm::Instruction *I, bool keep_shadows = false) const override;
+
   /**
    * Return a database with all checks.
    **/
@@ -255,9 +298,10 @@ class ClamPass : public llvm::ModulePass {
   using abs_dom_map_t = typename ClamGlobalAnalysis::abs_dom_map_t;
   using checks_db_t = typename ClamGlobalAnalysis::checks_db_t;
 
-  std::unique_ptr<CrabBuilderManager> m_cfg_builder_man;
+  // shared with ClamAAWrapperPass if it is available
+  std::shared_ptr<CrabBuilderManager> m_cfg_builder_man;
   AnalysisParams m_params;
-  std::unique_ptr<ClamGlobalAnalysis> m_ga;
+  std::shared_ptr<ClamGlobalAnalysis> m_ga;
 
 public:
   static char ID;
@@ -285,7 +329,8 @@ public:
   /* return the analysis options */
   const AnalysisParams &getAnalysisParams() const { return m_params; }
 
-  /* return true if there is Crab CFG for F */
+  /* return true if there is Crab CFG for F. It is false if the CFG
+     was released (AnalysisParams::stream_functions) */
   bool hasCfg(llvm::Function &F);
 
   /* return the Crab CFG associated to F */
@@ -303,6 +348,12 @@ public:
   llvm::Optional<clam_abstract_domain> getPost(const llvm::BasicBlock *BB,
                                                bool KeepShadows = false) const;
 
+  /**
+   * return invariants that hold after I if they were stored
+   **/
+  llvm::Optional<clam_abstract_domain> getPostStmt(const llvm::Instruction *I,
+                                                   bool KeepShadows = false) const;
+
   /**
    * Return true if there might be a feasible edge between b1 and b2
    **/
@@ -329,6 +380,200 @@ public:
   void printChecks(llvm::raw_ostream &o) const;
 };
 
+/**
+ * Return a hash of the instructions of f that changes if f is
+ * modified. It is used to detect functions modified since they were
+ * analyzed.
+ **/
+std::size_t getFunctionFingerprint(const llvm::Function &f);
+
+/**
+ * Result of the new pass manager analysis ClamAnalysis.
+ *
+ * The analysis does not modify the IR. Values do not need names but
+ * NameValuesPass can be run before ClamAnalysis to get readable names
+ * in the Crab CFGs.
+ *
+ * The result is kept across function transformations. Each function
+ * is fingerprinted when it is analyzed and the fingerprints are
+ * compared when the result is invalidated. The fingerprint covers the
+ * opcode, type, flags, predicate and operands of each instruction
+ * (constants by value) and a function handle detects a new function
+ * allocated at the address of a deleted one:
+ *
+ * - In intra-procedural mode without heap analysis, the modified
+ *   functions are only marked. Each one is re-analyzed by the first
+ *   query about it, and the invariants and query caches of the other
+ *   functions are kept.
+ *
+ * - Otherwise (inter-procedural mode or with a heap analysis), any
+ *   modification invalidates the whole result so that the heap
+ *   abstraction, the call graph and the global analysis are
+ *   recomputed together.
+ *
+ * Module transformations always invalidate the whole result.
+ *
+ * Unlike ClamGlobalAnalysis, queries are not thread-safe.
+ **/
+class ClamAnalysisResult: public ClamQueryAPI {
+  std::unique_ptr<llvm::TargetLibraryInfoWrapperPass> m_tli;
+  std::unique_ptr<CrabBuilderManager> m_cfg_builder_man;
+  AnalysisParams m_params;
+  std::unique_ptr<ClamGlobalAnalysis> m_ga;
+  struct Fingerprint {
+    // null if the function has been deleted
+    llvm::WeakVH m_fn;
+    std::size_t m_hash;
+  };
+  // The members below are updated by queries that re-analyze a
+  // modified function.
+  // functions that have been re-analyzed after they were modified
+  mutable llvm::DenseMap<const llvm::Function *, std::unique_ptr<IntraClam>> m_reanalyzed;
+  // functions modified since they were (re-)analyzed
+  mutable llvm::DenseSet<const llvm::Function *> m_modified;
+  // fingerprint of each function when it was (re-)analyzed
+  mutable llvm::DenseMap<const llvm::Function *, Fingerprint> m_fingerprints;
+  // one query cache per function
+  llvm::DenseMap<const llvm::Function *, std::unique_ptr<ClamQueryCache>> m_query_caches;
+
+  // Return true if modified functions can be re-analyzed one by one
+  bool supportsIncrementalUpdates() const;
+  // Return true if f differs from its fingerprint
+  bool hasChanged(const llvm::Function &f) const;
+  void setFingerprint(const llvm::Function &f) const;
+  // Re-analyze the modified function f
+  void reanalyze(const llvm::Function &f) const;
+  // Return the re-analysis of f or nullptr if f has never been
+  // modified. f is re-analyzed first if it is marked as modified.
+  const std::unique_ptr<IntraClam> *getReanalysis(const llvm::Function &f) const;
+  ClamQueryCache &getQueryCache(const llvm::Function &f);
+  std::function<llvm::Optional<clam_abstract_domain>(const llvm::BasicBlock *)>
+  getPreFn() const;
+
+public:
+  ClamAnalysisResult(llvm::Module &M, std::unique_ptr<HeapAbstraction> mem);
+  ClamAnalysisResult(ClamAnalysisResult &&o);
+  ~ClamAnalysisResult();
+
+  /* return the manager used to build all CFGs */
+  CrabBuilderManager &getCfgBuilderMan();
+
+  /* return the analysis options */
+  const AnalysisParams &getAnalysisParams() const { return m_params; }
+
+  /* return true if f has not been modified since it was analyzed or
+     if it will be re-analyzed by the next query about it */
+  bool isUpToDate(const llvm::Function &f) const;
+
+  /* return true if f has been modified since ClamAnalysis was run so
+     its invariants come (or will come) from a re-analysis */
+  bool isReanalyzed(const llvm::Function &f) const;
+
+  /* return invariants that hold at the entry of b */
+  llvm::Optional<clam_abstract_domain> getPre(const llvm::BasicBlock *b,
+                                              bool keep_shadows = false) const;
+
+  /* return invariants that hold at the exit of b */
+  llvm::Optional<clam_abstract_domain> getPost(const llvm::BasicBlock *b,
+                                               bool keep_shadows = false) const;
+
+  /* return invariants that hold after I if they were stored */
+  llvm::Optional<clam_abstract_domain>
+  getPostStmt(const llvm::Instruction *I, bool keep_shadows = false) const;
+
+  /* return true if there might be a feasible edge between b1 and b2 */
+  bool hasFeasibleEdge(const llvm::BasicBlock *b1,
+                       const llvm::BasicBlock *b2) const;
+
+  /* New pass manager API */
+  bool invalidate(llvm::Module &M, const llvm::PreservedAnalyses &PA,
+                  llvm::ModuleAnalysisManager::Invalidator &Inv);
+
+  /* ClamQueryAPI */
+  llvm::AliasResult alias(const llvm::MemoryLocation &,
+			  const llvm::MemoryLocation &,
+			  llvm::AAQueryInfo &) override;
+  
+  ClamQueryAPI::Range range(const llvm::Instruction &I) override;
+  
+  ClamQueryAPI::Range range(const llvm::BasicBlock &B,
+			    const llvm::Value &V) override;
+
+  llvm::Optional<ClamQueryAPI::TagVector> tags(const llvm::Instruction &I) override;
+  
+  llvm::Optional<ClamQueryAPI::TagVector> tags(const llvm::BasicBlock &B,
+					       const llvm::Value &V) override;
+};
+
+/**
+ * New pass manager module analysis that runs Clam with the options
+ * given by command line.
+ *
+ * Basic usage:
+ *    MAM.registerPass([] { return ClamAnalysis(); });
+ *    FAM.registerPass([] { return ClamFunctionAnalysis(); });
+ *    ...
+ *    // in a module pass
+ *    ClamAnalysisResult &clam = MAM.getResult<ClamAnalysis>(M);
+ *    // in a function pass (nullptr if ClamAnalysis is not cached or
+ *    // F has been modified since it was analyzed)
+ *    const ClamAnalysisResult *clam =
+ *        FAM.getResult<ClamFunctionAnalysis>(F).getClam();
+ **/
+class ClamAnalysis : public llvm::AnalysisInfoMixin<ClamAnalysis> {
+  friend llvm::AnalysisInfoMixin<ClamAnalysis>;
+  static llvm::AnalysisKey Key;
+public:
+  using HeapAbstractionFactory = std::function<std::unique_ptr<HeapAbstraction>(
+      llvm::Module &, llvm::ModuleAnalysisManager &)>;
+  using Result = ClamAnalysisResult;
+
+  /* If no factory is given then no heap analysis is used. */
+  ClamAnalysis(HeapAbstractionFactory factory = nullptr);
+
+  Result run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM);
+private:
+  HeapAbstractionFactory m_mem_factory;
+};
+
+/**
+ * New pass manager function analysis that gives read-only access to
+ * the (already computed) ClamAnalysis result from function passes.
+ * The result is not available if the function has been modified
+ * since ClamAnalysis analyzed it.
+ **/
+class ClamFunctionAnalysis
+    : public llvm::AnalysisInfoMixin<ClamFunctionAnalysis> {
+  friend llvm::AnalysisInfoMixin<ClamFunctionAnalysis>;
+  static llvm::AnalysisKey Key;
+public:
+  class Result {
+    const ClamAnalysisResult *m_clam;
+  public:
+    Result(const ClamAnalysisResult *clam) : m_clam(clam) {}
+    /* return nullptr if ClamAnalysis was not computed or F has been
+       modified since then */
+    const ClamAnalysisResult *getClam() const { return m_clam; }
+    bool invalidate(llvm::Function &F, const llvm::PreservedAnalyses &PA,
+                    llvm::FunctionAnalysisManager::Invalidator &Inv);
+  };
+
+  Result run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM);
+};
+
+/**
+ * New pass manager pass that prints for each function whether its
+ * ClamAnalysis results were kept or it has been re-analyzed after a
+ * modification, followed by the range of its return value.
+ **/
+class ClamPrinterPass : public llvm::PassInfoMixin<ClamPrinterPass> {
+  llvm::raw_ostream &m_os;
+public:
+  ClamPrinterPass(llvm::raw_ostream &os) : m_os(os) {}
+  llvm::PreservedAnalyses run(llvm::Module &M,
+                              llvm::ModuleAnalysisManager &MAM);
+};
+
 
 /**
  * Low-level API: intra-procedural analysis of a function.
@@ -438,6 +683,12 @@ public:
   llvm::Optional<clam_abstract_domain> getPost(const llvm::BasicBlock *b,
                                                bool keep_shadows = false) const;
 
+  /**
+   * Return invariants that hold after I if they were stored
+   **/
+  llvm::Optional<clam_abstract_domain>
+  getPostStmt(const llvm::Instruction *I, bool keep_shadows = false) const;
+
   /**
    * Return a database with all checks.
    **/
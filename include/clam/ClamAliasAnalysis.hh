@@ -0,0 +1,87 @@
+#pragma once
+
+/* Expose Clam alias information to LLVM alias analysis. */
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Pass.h"
+
+#include <memory>
+
+namespace clam {
+class ClamGlobalAnalysis;
+class ClamQueryAPI;
+class CrabBuilderManager;
+} // namespace clam
+
+namespace clam {
+
+/**
+ * An LLVM alias analysis result backed by ClamQueryAPI::alias. It
+ * answers NoAlias for memory locations that Clam proves to be in
+ * disjoint regions or pointed by references with disjoint tags. All
+ * other queries are chained to the rest of LLVM alias analyses.
+ **/
+class ClamAAResult : public llvm::AAResultBase<ClamAAResult> {
+  friend llvm::AAResultBase<ClamAAResult>;
+  ClamQueryAPI &m_clam;
+
+public:
+  explicit ClamAAResult(ClamQueryAPI &clam)
+      : llvm::AAResultBase<ClamAAResult>(), m_clam(clam) {}
+
+  ClamAAResult(ClamAAResult &&other)
+      : llvm::AAResultBase<ClamAAResult>(std::move(other)),
+        m_clam(other.m_clam) {}
+
+  llvm::AliasResult alias(const llvm::MemoryLocation &LocA,
+                          const llvm::MemoryLocation &LocB,
+                          llvm::AAQueryInfo &AAQI);
+};
+
+/**
+ * Legacy LLVM immutable pass that keeps the results of the last run
+ * of ClamPass so that they outlive ClamPass. ClamPass hands its
+ * results over if this pass is available. Use
+ * createClamExternalAAWrapperPass to plug them into the LLVM alias
+ * analysis chain.
+ *
+ * The results of a function are only used while the function has not
+ * been modified since ClamPass analyzed it.
+ **/
+class ClamAAWrapperPass : public llvm::ImmutablePass {
+  struct Fingerprint {
+    // null if the function has been deleted
+    llvm::WeakVH m_fn;
+    std::size_t m_hash;
+  };
+  // owned together with ClamPass
+  std::shared_ptr<CrabBuilderManager> m_cfg_builder_man;
+  std::shared_ptr<ClamGlobalAnalysis> m_ga;
+  std::unique_ptr<ClamAAResult> m_result;
+  // fingerprint of each function when ClamPass analyzed it
+  llvm::DenseMap<const llvm::Function *, Fingerprint> m_fingerprints;
+
+public:
+  static char ID;
+
+  ClamAAWrapperPass();
+
+  /* Replace the results with those of ClamPass on M */
+  void setClamResults(llvm::Module &M,
+                      std::shared_ptr<CrabBuilderManager> cfg_builder_man,
+                      std::shared_ptr<ClamGlobalAnalysis> ga);
+
+  /* Return nullptr if ClamPass has not been run or F has been modified
+     since it was analyzed */
+  ClamAAResult *getResult(const llvm::Function &F);
+
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+
+  virtual llvm::StringRef getPassName() const override {
+    return "Clam: alias analysis based on regions and tags";
+  }
+};
+
+} // end namespace clam
@@ -13,6 +13,18 @@ namespace clam {
 ////
 enum class CheckerKind { NOCHECKS = 0, ASSERTION = 1 };
 
+////
+// Kind of instructions whose invariants are stored at the statement
+// level. Each value is a bit position in
+// AnalysisParams::store_stmt_invariants.
+////
+enum class StmtInvariantsKind {
+  LOAD = 0,  /* load instructions */
+  GEP = 1,   /* getelementptr instructions */
+  CALL = 2,  /* call instructions */
+  MARKED = 3 /* instructions with clam-store-invariant metadata */
+};
+
 /**
  * Class to set analysis options
  **/
@@ -37,6 +49,13 @@ struct AnalysisParams {
   bool print_unjustified_assumptions;
   bool print_summaries; /*unused*/
   bool store_invariants;
+  /* set of StmtInvariantsKind bits: store the invariants after those
+     instructions so that clients do not replay their blocks */
+  unsigned store_stmt_invariants;
+  /* intra-procedural only: release the CFG and invariants of each
+     function once it has been analyzed. The variable factory is
+     shared by all functions so their crab variables are kept. */
+  bool stream_functions;
   bool keep_shadow_vars;
   CheckerKind check;
   unsigned check_verbose;
@@ -49,7 +68,13 @@ struct AnalysisParams {
         relational_threshold(10000), widening_delay(1), narrowing_iters(10),
         widening_jumpset(0), stats(false), print_invars(false),
         print_preconds(false), print_unjustified_assumptions(false),
-        print_summaries(false), store_invariants(true), keep_shadow_vars(false),
+        print_summaries(false), store_invariants(true),
+        store_stmt_invariants(0), stream_functions(false),
+        keep_shadow_vars(false),
         check(CheckerKind::NOCHECKS), check_verbose(0) {}
+
+  bool storeStmtInvariants(StmtInvariantsKind kind) const {
+    return store_stmt_invariants & (1U << static_cast<unsigned>(kind));
+  }
 };
 } // end namespace clam
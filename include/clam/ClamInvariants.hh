@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+ * Helpers to read the invariants inferred by Clam.
+ */
+
+#include "clam/Clam.hh"
+#include "clam/ClamQueryAPI.hh"
+#include "clam/crab/crab_lang.hh"
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace llvm {
+class Instruction;
+} // end namespace llvm
+
+namespace clam {
+
+/* Return the instruction defined by s if s defines only one variable */
+const llvm::Instruction *getDefInst(const statement_t &s);
+
+/* Return the interval of v in inv if it is not bottom, it is finite
+   and it fits in int64_t. */
+llvm::Optional<ClamQueryAPI::Range> getInt64Range(clam_abstract_domain &inv,
+                                                  const var_t &v);
+
+/**
+ * Crab only keeps the invariants that hold at the entry and exit of
+ * each block. The functions below rebuild the invariants of the
+ * statements of bb by propagating pre, the invariant at the entry of
+ * bb, forward through the block.
+ *
+ * Callsites are ignored so the result might be imprecise if the
+ * analysis was inter-procedural because the context that the
+ * inter-procedural analysis had cannot be reconstructed.
+ *
+ * fn is called on each statement in order with the invariant that
+ * holds either after (forEachStmtPost) or before (forEachStmtPre) the
+ * statement. The propagation stops as soon as fn returns false.
+ **/
+using StmtInvariantFn = llvm::function_ref<bool(const statement_t &,
+                                                clam_abstract_domain &)>;
+
+void forEachStmtPost(basic_block_t &bb, clam_abstract_domain pre,
+                     StmtInvariantFn fn);
+
+void forEachStmtPre(basic_block_t &bb, clam_abstract_domain pre,
+                    StmtInvariantFn fn);
+
+} // end namespace clam
@@ -12,7 +12,16 @@ namespace llvm {
 }
 
 namespace clam {
-  
+
+/**
+ * Thread-safety: once the analysis has finished, the methods of this
+ * class can be called concurrently from multiple threads on
+ * IntraGlobalClam, InterGlobalClam and ClamPass. Other methods of
+ * these classes (e.g., getPre) are not thread-safe.
+ *
+ * ClamAnalysisResult is not thread-safe because a query might
+ * re-analyze a modified function.
+ **/
 class ClamQueryAPI {
 public:
   
@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+ * A flat, sorted table with the ranges of all integer values of a
+ * module inferred by Clam.
+ */
+
+#include "clam/ClamQueryAPI.hh"
+#include "llvm/ADT/Optional.h"
+
+#include <vector>
+
+namespace llvm {
+class Function;
+class Module;
+class Value;
+class raw_ostream;
+} // namespace llvm
+
+namespace clam {
+class ClamGlobalAnalysis;
+} // namespace clam
+
+namespace clam {
+
+/**
+ * The table is built in one sweep over the invariants stored by
+ * ClamGlobalAnalysis. After that, the abstract domains are not needed
+ * anymore and lookups are binary searches on a contiguous array.
+ *
+ * Only values with a finite range that fits in int64_t are stored.
+ *
+ * Basic usage:
+ *    ClamRangeTable table(M, ga);
+ *    ClamQueryAPI::Range r = table.range(V);
+ **/
+class ClamRangeTable {
+public:
+  using Range = typename ClamQueryAPI::Range;
+
+  struct Entry {
+    const llvm::Value *value;
+    int64_t lo;
+    int64_t hi;
+  };
+
+  using const_iterator = std::vector<Entry>::const_iterator;
+
+private:
+  // sorted by value
+  std::vector<Entry> m_table;
+
+  void addFunction(const llvm::Function &F, ClamGlobalAnalysis &ga);
+  void sortTable();
+
+public:
+  ClamRangeTable() = default;
+
+  ClamRangeTable(const llvm::Module &M, ClamGlobalAnalysis &ga);
+
+  /* table with the values of F only */
+  ClamRangeTable(const llvm::Function &F, ClamGlobalAnalysis &ga);
+
+  /* return the range of v or None if v is not in the table */
+  llvm::Optional<Range> lookup(const llvm::Value &v) const;
+
+  /* return the range of v or [-oo,+oo] if v is not in the table */
+  Range range(const llvm::Value &v) const;
+
+  std::size_t size() const { return m_table.size(); }
+  bool empty() const { return m_table.empty(); }
+  const_iterator begin() const { return m_table.begin(); }
+  const_iterator end() const { return m_table.end(); }
+
+  /**
+   * Write the table as text. There is one line per value:
+   *
+   *    <function name> <value id> <lo> <hi>
+   *
+   * where value id is the position of the value in its function
+   * (arguments first, then instructions in program order).
+   **/
+  void write(const llvm::Module &M, llvm::raw_ostream &o) const;
+
+  /* write only the lines of F */
+  void write(const llvm::Function &F, llvm::raw_ostream &o) const;
+};
+
+} // end namespace clam
@@ -22,19 +22,30 @@ struct DummyHeapAbstraction : public HeapAbstraction {
     return Region();
   }
 
-  RegionVec getOnlyReadRegions(const llvm::Function &) { return RegionVec(); }
+  const RegionVec &getOnlyReadRegions(const llvm::Function &) {
+    return m_empty;
+  }
 
-  RegionVec getModifiedRegions(const llvm::Function &) { return RegionVec(); }
+  const RegionVec &getModifiedRegions(const llvm::Function &) {
+    return m_empty;
+  }
 
-  RegionVec getNewRegions(const llvm::Function &) { return RegionVec(); }
+  const RegionVec &getNewRegions(const llvm::Function &) { return m_empty; }
 
-  RegionVec getOnlyReadRegions(const llvm::CallInst &) { return RegionVec(); }
+  const RegionVec &getOnlyReadRegions(const llvm::CallInst &) {
+    return m_empty;
+  }
 
-  RegionVec getModifiedRegions(const llvm::CallInst &) { return RegionVec(); }
+  const RegionVec &getModifiedRegions(const llvm::CallInst &) {
+    return m_empty;
+  }
 
-  RegionVec getNewRegions(const llvm::CallInst &) { return RegionVec(); }
+  const RegionVec &getNewRegions(const llvm::CallInst &) { return m_empty; }
 
   llvm::StringRef getName() const { return "DummyHeapAbstraction"; }
+
+private:
+  RegionVec m_empty;
 };
 
 } // namespace clam
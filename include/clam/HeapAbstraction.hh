@@ -241,6 +241,11 @@ public:
 
   virtual llvm::StringRef getName() const = 0;
 
+  // Return true if two regions might be disambiguated although they
+  // can overlap (e.g., the heap analysis was asked to ignore unknown
+  // or external memory).
+  virtual bool mayDisambiguateUnsoundly() const { return false; }
+
   // TODO: mark all these methods as const.
 
   // fun is used to know in which function ptr lives.
@@ -250,28 +255,32 @@ public:
 
   /**========  These functions allow to purify functions ========**/
 
+  // The returned vectors are owned by the heap abstraction. Their
+  // order matters: the i-th region of a function corresponds to the
+  // i-th region of each of its callsites.
+
   // Read-Only regions reachable by function parameters and globals
   // but not returns
-  virtual RegionVec getOnlyReadRegions(const llvm::Function &) = 0;
+  virtual const RegionVec &getOnlyReadRegions(const llvm::Function &) = 0;
 
   // Written regions reachable by function parameters and globals but
   // not returns
-  virtual RegionVec getModifiedRegions(const llvm::Function &) = 0;
+  virtual const RegionVec &getModifiedRegions(const llvm::Function &) = 0;
 
   // Regions that are reachable only from the return of the function
-  virtual RegionVec getNewRegions(const llvm::Function &) = 0;
+  virtual const RegionVec &getNewRegions(const llvm::Function &) = 0;
 
   // Read-only regions at the caller that are mapped to callee's
   // formal parameters and globals.
-  virtual RegionVec getOnlyReadRegions(const llvm::CallInst &) = 0;
+  virtual const RegionVec &getOnlyReadRegions(const llvm::CallInst &) = 0;
 
   // Written regions at the caller that are mapped to callee's formal
   // parameters and globals.
-  virtual RegionVec getModifiedRegions(const llvm::CallInst &) = 0;
+  virtual const RegionVec &getModifiedRegions(const llvm::CallInst &) = 0;
 
   // Regions at the caller that are mapped to those that are only
   // reachable from callee's returns.
-  virtual RegionVec getNewRegions(const llvm::CallInst &) = 0;
+  virtual const RegionVec &getNewRegions(const llvm::CallInst &) = 0;
 };
 
 } // namespace clam
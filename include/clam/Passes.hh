@@ -26,6 +26,9 @@ llvm::Pass *createNullCheckPass();
 llvm::Pass *createUseAfterFreeCheckPass();
 // Postprocessing passes
 llvm::Pass *createOptimizerPass();  
+// Alias analysis passes
+llvm::Pass *createClamAAWrapperPass();
+llvm::Pass *createClamExternalAAWrapperPass();
 } // namespace clam
 
 #ifdef HAVE_LLVM_SEAHORN
@@ -100,22 +100,27 @@ public:
   Region getRegion(const llvm::Function &F, const llvm::Value &V,
                    unsigned offset, const llvm::Type &AccessedType);
 
-  virtual RegionVec getOnlyReadRegions(const llvm::Function &F) override;
+  virtual const RegionVec &getOnlyReadRegions(const llvm::Function &F) override;
 
-  virtual RegionVec getModifiedRegions(const llvm::Function &F) override;
+  virtual const RegionVec &getModifiedRegions(const llvm::Function &F) override;
 
-  virtual RegionVec getNewRegions(const llvm::Function &F) override;
+  virtual const RegionVec &getNewRegions(const llvm::Function &F) override;
 
-  virtual RegionVec getOnlyReadRegions(const llvm::CallInst &I) override;
+  virtual const RegionVec &getOnlyReadRegions(const llvm::CallInst &I) override;
 
-  virtual RegionVec getModifiedRegions(const llvm::CallInst &I) override;
+  virtual const RegionVec &getModifiedRegions(const llvm::CallInst &I) override;
 
-  virtual RegionVec getNewRegions(const llvm::CallInst &I) override;
+  virtual const RegionVec &getNewRegions(const llvm::CallInst &I) override;
 
   virtual llvm::StringRef getName() const override {
     return "SeaDsaHeapAbstraction";
   }
 
+  virtual bool mayDisambiguateUnsoundly() const override {
+    return m_disambiguate_unknown || m_disambiguate_ptr_cast ||
+           m_disambiguate_external;
+  }
+
 private:
   seadsa::GlobalAnalysis *m_dsa;
   SetFactory *m_fac;
@@ -135,9 +140,13 @@ private:
   llvm::DenseMap<const llvm::Function *, RegionVec> m_func_mods;
   // regions reachable only from return parameters
   llvm::DenseMap<const llvm::Function *, RegionVec> m_func_news;
-  llvm::DenseMap<const llvm::CallInst *, RegionVec> m_callsite_accessed;
   llvm::DenseMap<const llvm::CallInst *, RegionVec> m_callsite_mods;
   llvm::DenseMap<const llvm::CallInst *, RegionVec> m_callsite_news;
+  // accessed minus modified regions
+  llvm::DenseMap<const llvm::Function *, RegionVec> m_func_only_reads;
+  llvm::DenseMap<const llvm::CallInst *, RegionVec> m_callsite_only_reads;
+  // returned if a function or callsite has no regions
+  RegionVec m_empty;
 };
 
 } // end namespace clam
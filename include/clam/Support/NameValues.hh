@@ -2,6 +2,7 @@
 
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
 
 namespace clam {
@@ -20,4 +21,10 @@ public:
 
   virtual llvm::StringRef getPassName() const { return "Clam: Name values"; }
 };
+
+/* New pass manager version of NameValues */
+class NameValuesPass : public llvm::PassInfoMixin<NameValuesPass> {
+public:
+  llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &);
+};
 } // namespace clam
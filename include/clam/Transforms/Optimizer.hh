@@ -2,11 +2,14 @@
 
 /* Optimize LLVM bitcode using invariants inferred by Clam. */
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Pass.h"
 #include <memory>
 
 namespace llvm {
+class BasicBlock;
 class Function;
+class MDNode;
 class Module;
 class CallGraph;
 class DominatorTree;
@@ -26,6 +29,12 @@ enum class InvariantsLocation {
     ALL          /* insert invariants after each instruction*/
 };
 
+/* What Clam knows about the value returned by a function */
+struct ReturnFacts {
+  llvm::MDNode *range; /* nullptr if unknown */
+  bool nonnull;
+};
+  
 class Optimizer {
   clam::ClamGlobalAnalysis &m_clam;
   llvm::CallGraph *m_cg;
@@ -34,8 +43,17 @@ class Optimizer {
   InvariantsLocation m_invLoc;
   bool m_removeDeadCode;
   bool m_replaceWithConstants;
+  bool m_addRangeMetadata;
+  bool m_lowerChecks;
+  bool m_narrowIntegers;
+  bool m_loopTripCount;
+  bool m_foldConditions;
   llvm::Function *m_assumeFn;
+  llvm::Function *m_trapFn;
+  llvm::DenseMap<const llvm::Function *, ReturnFacts> m_retFacts;
   bool runOnFunction(llvm::Function &F);
+  bool instrumentBlocks(llvm::Function &F, llvm::DominatorTree *dt);
+  bool addCallRangeMetadata(llvm::BasicBlock &B);
 public:
 
   /** 
@@ -50,6 +68,29 @@ public:
    *
    *  - If replaceWithConstants then it replaces certain values (e.g.,
    *    left-hand-side of LoadInst) with constants.
+   *
+   *  - If addRangeMetadata then it adds !range metadata to integer
+   *    loads and calls, and !nonnull metadata (loads) or nonnull
+   *    return attributes (calls) to pointers.
+   *
+   *  - If lowerChecks then it removes the checks added by the
+   *    property instrumentation passes (e.g., NullCheck) that are
+   *    proven safe and replaces the others with a branch to
+   *    llvm.trap.
+   *
+   *  - If narrowIntegers then it rewrites integer operations whose
+   *    operands and result fit in a smaller type (8, 16 or 32 bits)
+   *    to that type.
+   *
+   *  - If loopTripCount then it adds the maximum trip count of each
+   *    loop, bounded by its induction variables, as loop metadata
+   *    and llvm.assume calls on the induction variable at the loop
+   *    header. Branch weights are added only if the trip count is
+   *    exact. It requires LoopInfo.
+   *
+   *  - If foldConditions then it replaces comparisons with constants
+   *    if their operand ranges fix the outcome, and removes switch
+   *    cases outside the range of the switch condition.
   */
   Optimizer(clam::ClamGlobalAnalysis  &clam,
 	    llvm::CallGraph *callgraph,
@@ -57,7 +98,12 @@ public:
 	    std::function<llvm::LoopInfo*(llvm::Function*)> LI,
 	    InvariantsLocation addInvariants,
 	    bool removeDeadCode,
-	    bool replaceWithConstants);
+	    bool replaceWithConstants,
+	    bool addRangeMetadata,
+	    bool lowerChecks,
+	    bool narrowIntegers,
+	    bool loopTripCount,
+	    bool foldConditions);
   bool runOnModule(llvm::Module &M);
 };
   
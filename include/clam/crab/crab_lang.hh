@@ -18,33 +18,62 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 
 namespace clam {
 
+// Return a printable name for v. Values do not need names to be
+// translated so an unnamed value is named after its slot number as
+// NameValues would do. This is slow but it is only used for printing.
+inline std::string getValueNameForPrinting(const llvm::Value &v) {
+  if (v.hasName()) {
+    return v.getName().str();
+  }
+  std::string res;
+  llvm::raw_string_ostream os(res);
+  v.printAsOperand(os, false);
+  os.flush();
+  if (!res.empty() && res[0] == '%') {
+    res[0] = '_';
+  }
+  return res;
+}
+
 // This wrapper is needed because we can have crab blocks which do not
 // correspond to llvm blocks.
+//
+// Block wrappers are identified, ordered and hashed by their id which
+// must be unique within a CFG. Names are only used for printing and
+// they are computed on demand.
 class llvm_basic_block_wrapper : public crab::indexable {
 public:
   // the new block represents that the control is at b
   llvm_basic_block_wrapper(const llvm::BasicBlock *b, std::size_t id)
-      : m_bb(b), m_edge(nullptr, nullptr), m_name(b->getName()), m_id(id) {
-    assert(b->hasName());
-  }
+      : m_bb(b), m_edge(nullptr, nullptr), m_id(id) {}
 
   // the new block represents that the control goes from src to dst
   llvm_basic_block_wrapper(const llvm::BasicBlock *src,
-                           const llvm::BasicBlock *dst, std::string name,
-                           std::size_t id)
-      : m_bb(nullptr), m_edge(src, dst), m_name(name), m_id(id) {}
+                           const llvm::BasicBlock *dst, std::size_t id)
+      : m_bb(nullptr), m_edge(src, dst), m_id(id) {}
 
   llvm_basic_block_wrapper()
-      : m_bb(nullptr), m_edge(nullptr, nullptr), m_name(""), m_id(0) {}
+      : m_bb(nullptr), m_edge(nullptr, nullptr), m_id(0) {}
 
   // for boost bgl
   llvm_basic_block_wrapper(std::nullptr_t)
-      : m_bb(nullptr), m_edge(nullptr, nullptr), m_name(""), m_id(0) {}
-
-  std::string get_name() const { return m_name; }
+      : m_bb(nullptr), m_edge(nullptr, nullptr), m_id(0) {}
+
+  // The name of a llvm basic block is taken from the block so it
+  // should not be called after the block has been deleted.
+  std::string get_name() const {
+    if (m_bb) {
+      return getValueNameForPrinting(*m_bb);
+    } else if (m_id == 0) {
+      return "";
+    } else {
+      return "__@bb_" + std::to_string(m_id);
+    }
+  }
 
   bool is_edge() const { return !m_bb && (m_edge.first && m_edge.second); }
 
@@ -56,7 +85,7 @@ public:
   }
 
   bool operator==(const llvm_basic_block_wrapper &other) const {
-    return m_name == other.m_name;
+    return m_id == other.m_id;
   }
 
   bool operator!=(const llvm_basic_block_wrapper &other) const {
@@ -64,10 +93,10 @@ public:
   }
 
   bool operator<(const llvm_basic_block_wrapper &other) const {
-    return m_name < other.m_name;
+    return m_id < other.m_id;
   }
 
-  std::size_t hash() const { return std::hash<std::string>{}(m_name); }
+  std::size_t hash() const { return std::hash<std::size_t>{}(m_id); }
 
   // used by some crab datastructures
   virtual ikos::index_t index() const override { return m_id; }
@@ -84,8 +113,6 @@ private:
   const llvm::BasicBlock *m_bb;
   // the block wrapper corresponds to a llvm edge
   std::pair<const llvm::BasicBlock *, const llvm::BasicBlock *> m_edge;
-  // block wrapper name
-  std::string m_name;
   // block wrapper unique identifier
   std::size_t m_id;
 };
@@ -160,7 +187,7 @@ namespace crab {
 template <> class variable_name_traits<const llvm::Value *> {
 public:
   static std::string to_string(const llvm::Value *v) {
-    return v->getName().str();
+    return clam::getValueNameForPrinting(*v);
   }
 };
 
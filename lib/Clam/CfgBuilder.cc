@@ -43,7 +43,12 @@
  */
 
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/IR/CallSite.h"
@@ -81,20 +86,6 @@ using namespace crab::cfg;
 
 namespace clam {
 
-static bool checkAllDefinitionsHaveNames(const Function &F) {
-  for (const BasicBlock &BB : F) {
-    if (!BB.hasName()) {
-      return false;
-    }
-    for (const Instruction &I : BB) {
-      if (!I.hasName() && !(I.getType()->isVoidTy())) {
-        return false;
-      }
-    }
-  }
-  return true;
-}
-
 static std::string valueToStr(const Value &V) {
   std::string res;
   raw_string_ostream os(res);
@@ -396,6 +387,97 @@ static var_t normalizeFuncParamOrRet(Value &v, basic_block_t &bb,
   CLAM_ERROR("cannot normalize function parameter or return value");
 }
 
+// Collect which region variables of a function must be initialized
+// while the function is translated.
+//
+// A region variable is initialized at the entry of the function if it
+// is used by some statement but it is not a function input or the
+// output of a callsite or intrinsic. The sets are bitsets indexed by
+// a dense numbering of the region variables of the function.
+class RegionInitTracker {
+  crabLitFactory &m_lfac;
+  // all region variables seen so far. The position of a variable is
+  // its bit in the sets.
+  std::vector<var_t> m_vars;
+  DenseMap<ikos::index_t, unsigned> m_ids;
+  BitVector m_may_init;
+  BitVector m_must_not_init;
+  // we need to be careful with region cast statements
+  BitVector m_cast_src;
+  BitVector m_cast_dst;
+
+  void insert(BitVector &set, const var_t &v) {
+    assert(v.get_type().is_region());
+    auto res = m_ids.insert({v.index(), m_vars.size()});
+    if (res.second) {
+      m_vars.push_back(v);
+      unsigned n = m_vars.size();
+      m_may_init.resize(n);
+      m_must_not_init.resize(n);
+      m_cast_src.resize(n);
+      m_cast_dst.resize(n);
+    }
+    set.set(res.first->second);
+  }
+
+  bool test(const BitVector &set, unsigned id) const { return set.test(id); }
+
+public:
+  RegionInitTracker(crabLitFactory &lfac) : m_lfac(lfac) {}
+
+  // Return the region variable of rgn and record that it is used by
+  // a statement.
+  var_t mkRegionVar(Region rgn) {
+    var_t v = m_lfac.mkRegionVar(rgn);
+    mayInit(v);
+    return v;
+  }
+
+  void mayInit(const var_t &v) { insert(m_may_init, v); }
+
+  void mustNotInit(const var_t &v) { insert(m_must_not_init, v); }
+
+  // outputs := f(inputs) where f is a function or a crab intrinsic.
+  // Output regions that are not inputs are created by f so they must
+  // not be initialized.
+  template <typename InputRange>
+  void call(const std::vector<var_t> &outputs, const InputRange &inputs) {
+    for (const var_t &v : inputs) {
+      if (v.get_type().is_region()) {
+        mayInit(v);
+      }
+    }
+    for (const var_t &v : outputs) {
+      if (v.get_type().is_region() &&
+          std::find(inputs.begin(), inputs.end(), v) == inputs.end()) {
+        mustNotInit(v);
+      }
+    }
+  }
+
+  void cast(const var_t &src, const var_t &dst) {
+    insert(m_cast_src, src);
+    insert(m_cast_dst, dst);
+  }
+
+  // Return the region variables to be initialized sorted by index
+  std::vector<var_t> getRegionsToInit() const {
+    std::vector<var_t> res;
+    for (unsigned id = 0, n = m_vars.size(); id < n; ++id) {
+      if (!test(m_may_init, id) || test(m_must_not_init, id)) {
+        continue;
+      }
+      // Do not initialize z in "y := foo(x); cast y to z";
+      if (test(m_cast_dst, id) && !test(m_cast_src, id)) {
+        continue;
+      }
+      res.push_back(m_vars[id]);
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+  }
+};
+
 //! Translate PHI nodes
 struct CrabInterBlockBuilder : public InstVisitor<CrabInterBlockBuilder> {
 
@@ -409,19 +491,215 @@ struct CrabInterBlockBuilder : public InstVisitor<CrabInterBlockBuilder> {
   const BasicBlock &m_inc_BB;
   // builder parameters
   const CrabBuilderParams &m_params;
+  // region variables that need initialization
+  RegionInitTracker &m_rgn_init;
 
   CrabInterBlockBuilder(crabLitFactory &lfac, HeapAbstraction &mem,
                         RegionSet &func_regions, const DataLayout &dl,
                         basic_block_t &bb, const BasicBlock &inc_BB,
-                        const CrabBuilderParams &params)
+                        const CrabBuilderParams &params,
+                        RegionInitTracker &rgn_init)
       : m_lfac(lfac), m_mem(mem), m_func_regions(func_regions), m_dl(dl),
-        m_bb(bb), m_inc_BB(inc_BB), m_params(params) {}
+        m_bb(bb), m_inc_BB(inc_BB), m_params(params), m_rgn_init(rgn_init) {}
+
+  // Save in a fresh variable the value of phi_v before any PHI node
+  // of its block is evaluated.
+  void saveOldValue(const PHINode &phi_v,
+                    DenseMap<const Value *, var_t> &old_val_map) {
+    if (old_val_map.count(&phi_v)) {
+      return;
+    }
+    crab_lit_ref_t phi_val_lit = m_lfac.getLit(phi_v);
+    if (!phi_val_lit) {
+      return;
+    }
+    // non-shadow mem phi node: bool, integer, or pointer
+    if (phi_val_lit->isBool()) {
+      var_t lhs = m_lfac.mkBoolVar();
+      if (phi_val_lit->isVar()) {
+        m_bb.bool_assign(lhs, phi_val_lit->getVar());
+      } else {
+        m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_lit)
+                                  ? lin_cst_t::get_true()
+                                  : lin_cst_t::get_false());
+      }
+      old_val_map.insert({&phi_v, lhs});
+    } else if (phi_val_lit->isInt()) {
+      var_t lhs = m_lfac.mkIntVar(phi_v.getType()->getIntegerBitWidth());
+      m_bb.assign(lhs, m_lfac.getExp(phi_val_lit));
+      old_val_map.insert({&phi_v, lhs});
+    } else if (isReference(phi_v, m_params)) {
+      assert(phi_val_lit->isRef());
+      var_t lhs = m_lfac.mkRefVar();
+      if (phi_val_lit->isVar()) {
+        Region rgn_phi_val =
+            getRegion(m_mem, m_func_regions, m_params, phi_v, phi_v);
+        m_bb.gep_ref(lhs, m_rgn_init.mkRegionVar(rgn_phi_val),
+                     phi_val_lit->getVar(),
+                     m_rgn_init.mkRegionVar(rgn_phi_val));
+      } else {
+        m_bb.assume_ref(ref_cst_t::mk_null(lhs));
+      }
+      old_val_map.insert({&phi_v, lhs});
+    } else {
+      /* unreachable */
+    }
+  }
+
+  // Translate phi := v where v is the incoming value of phi. If v has
+  // an entry in old_val_map then the saved value is used instead.
+  void assignPhi(const PHINode &phi, const Value &v,
+                 const DenseMap<const Value *, var_t> &old_val_map) {
+    /// Regular PHI node: bool, integer, or pointer
+    crab_lit_ref_t lhs_lit = m_lfac.getLit(phi);
+    if (!lhs_lit || !lhs_lit->isVar()) {
+      CLAM_ERROR("unexpected PHI instruction");
+    }
+    var_t lhs = lhs_lit->getVar();
+    auto it = old_val_map.find(&v);
+    if (it != old_val_map.end()) {
+      // -- use old version if exists
+      if (isBool(phi)) {
+        m_bb.bool_assign(lhs, it->second);
+      } else if (phi.getType()->isIntegerTy()) {
+        m_bb.assign(lhs, it->second);
+      } else if (isReference(phi, m_lfac.getCfgBuilderParams())) {
+        Region rgn_phi = getRegion(m_mem, m_func_regions, m_params, phi, phi);
+        m_bb.gep_ref(lhs, m_rgn_init.mkRegionVar(rgn_phi), it->second,
+                     m_rgn_init.mkRegionVar(rgn_phi));
+      }
+    } else {
+      if (crab_lit_ref_t phi_val_lit = m_lfac.getLit(v)) {
+        if (phi_val_lit->isBool()) {
+          if (phi_val_lit->isVar()) {
+            m_bb.bool_assign(lhs, phi_val_lit->getVar());
+          } else {
+            m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_lit)
+                                      ? lin_cst_t::get_true()
+                                      : lin_cst_t::get_false());
+          }
+        } else if (phi_val_lit->isInt()) {
+          m_bb.assign(lhs, m_lfac.getExp(phi_val_lit));
+        } else if (isReference(v, m_params)) {
+          assert(phi_val_lit->isRef());
+          if (phi_val_lit->isVar()) {
+            Region rgn_phi =
+                getRegion(m_mem, m_func_regions, m_params, phi, phi);
+            Region rgn_phi_v =
+                getRegion(m_mem, m_func_regions, m_params, phi, v);
+            m_bb.gep_ref(lhs, m_rgn_init.mkRegionVar(rgn_phi),
+                         phi_val_lit->getVar(),
+                         m_rgn_init.mkRegionVar(rgn_phi_v));
+          } else {
+            m_bb.havoc(lhs, phi.getName().str() + " := null");
+            m_bb.assume_ref(ref_cst_t::mk_null(lhs));
+          }
+        } else {
+          /* unreachable*/
+        }
+      } else {
+        // we can be here if the incoming value is a bignum and we
+        // don't allow bignums.
+        m_bb.havoc(lhs, valueToStr(phi) + " TODO");
+      }
+    }
+  }
+
+  // The PHI nodes of BB are a parallel copy. Emit the copies in an
+  // order such that a PHI node is overwritten only after all the
+  // copies that read its old value. A fresh variable is needed only
+  // to break a cycle of copies (e.g., a swap). Copies of the form
+  // x := x are removed.
+  void sequentializePhiCopies(BasicBlock &BB) {
+    // Map an PHI incoming value to a Crab variable
+    DenseMap<const Value *, var_t> old_val_map;
+    // the parallel copy: phi := incoming value
+    SmallVector<std::pair<const PHINode *, const Value *>, 8> copies;
+    // index in copies of each PHI node that must be assigned
+    DenseMap<const PHINode *, unsigned> copy_of;
+    // number of pending copies that read the old value of a PHI node
+    DenseMap<const PHINode *, unsigned> num_readers;
+
+    for (auto curr = BB.begin(); isa<PHINode>(curr); ++curr) {
+      const PHINode &phi = *cast<PHINode>(curr);
+      if (!isTracked(phi, m_lfac.getCfgBuilderParams())) {
+        continue;
+      }
+      if (phi.getName().startswith("shadow.mem")) {
+        // XXX: ignore PHI shadow mem instructions.
+        continue;
+      }
+      const Value &v = *phi.getIncomingValueForBlock(&m_inc_BB);
+      if (&v == &phi) {
+        continue;
+      }
+      copy_of.insert({&phi, copies.size()});
+      copies.push_back({&phi, &v});
+    }
+
+    // Return the PHI node whose old value is read by v, if any.
+    auto readsPhi = [&BB, &copy_of](const Value *v) -> const PHINode * {
+      const PHINode *phi_v = dyn_cast<PHINode>(v);
+      if (phi_v && phi_v->getParent() == &BB && copy_of.count(phi_v)) {
+        return phi_v;
+      }
+      return nullptr;
+    };
+
+    for (auto &kv : copies) {
+      if (const PHINode *phi_v = readsPhi(kv.second)) {
+        num_readers[phi_v]++;
+      }
+    }
+
+    // copies whose lhs is not read by any pending copy
+    SmallVector<unsigned, 8> ready;
+    for (unsigned i = 0, e = copies.size(); i < e; ++i) {
+      if (num_readers.lookup(copies[i].first) == 0) {
+        ready.push_back(i);
+      }
+    }
+
+    std::vector<bool> done(copies.size(), false);
+    unsigned num_done = 0, next = 0;
+    while (num_done < copies.size()) {
+      while (!ready.empty()) {
+        unsigned i = ready.pop_back_val();
+        const PHINode &phi = *copies[i].first;
+        const Value &v = *copies[i].second;
+        assignPhi(phi, v, old_val_map);
+        done[i] = true;
+        num_done++;
+        const PHINode *phi_v = readsPhi(&v);
+        if (phi_v && !old_val_map.count(phi_v) && --num_readers[phi_v] == 0) {
+          ready.push_back(copy_of[phi_v]);
+        }
+      }
+      if (num_done == copies.size()) {
+        break;
+      }
+      // -- only cycles are left: save the old value of one PHI node
+      //    so that its copy can be done.
+      while (done[next]) {
+        ++next;
+      }
+      const PHINode &phi = *copies[next].first;
+      saveOldValue(phi, old_val_map);
+      num_readers[&phi] = 0;
+      ready.push_back(next);
+    }
+  }
 
   void visitBasicBlock(BasicBlock &BB) {
     if (!isa<PHINode>(BB.begin())) {
       return;
     }
 
+    if (m_params.minimize_phi_copies) {
+      sequentializePhiCopies(BB);
+      return;
+    }
+
     // Map an PHI incoming value to a Crab variable
     DenseMap<const Value *, var_t> old_val_map;
 
@@ -438,51 +716,13 @@ struct CrabInterBlockBuilder : public InstVisitor<CrabInterBlockBuilder> {
       }
       const PHINode *phi_v = dyn_cast<PHINode>(&v);
       if (phi_v && (phi_v->getParent() == &BB)) {
+        if (phi->getName().startswith("shadow.mem")) {
+          // XXX: Ignore PHI shadow mem instructions.
+          continue;
+        }
         // -- save the old version of the variable that maps to the
         //    phi node v
-        auto it = old_val_map.find(&v);
-        if (it == old_val_map.end()) {
-          if (crab_lit_ref_t phi_val_lit = m_lfac.getLit(v)) {
-            // non-shadow mem phi node: bool, integer, or pointer
-
-            if (phi->getName().startswith("shadow.mem")) {
-              // XXX: Ignore PHI shadow mem instructions.
-              continue;
-            }
-
-            if (phi_val_lit->isBool()) {
-              var_t lhs = m_lfac.mkBoolVar();
-              if (phi_val_lit->isVar()) {
-                m_bb.bool_assign(lhs, phi_val_lit->getVar());
-              } else {
-                m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_lit)
-                                          ? lin_cst_t::get_true()
-                                          : lin_cst_t::get_false());
-              }
-              old_val_map.insert({&v, lhs});
-            } else if (phi_val_lit->isInt()) {
-              var_t lhs =
-                  m_lfac.mkIntVar(phi_v->getType()->getIntegerBitWidth());
-              m_bb.assign(lhs, m_lfac.getExp(phi_val_lit));
-              old_val_map.insert({&v, lhs});
-            } else if (isReference(v, m_params)) {
-              assert(phi_val_lit->isRef());
-              var_t lhs = m_lfac.mkRefVar();
-              if (phi_val_lit->isVar()) {
-                Region rgn_phi_val =
-                    getRegion(m_mem, m_func_regions, m_params, *phi_v, *phi_v);
-                m_bb.gep_ref(lhs, m_lfac.mkRegionVar(rgn_phi_val),
-                             phi_val_lit->getVar(),
-                             m_lfac.mkRegionVar(rgn_phi_val));
-              } else {
-                m_bb.assume_ref(ref_cst_t::mk_null(lhs));
-              }
-              old_val_map.insert({&v, lhs});
-            } else {
-              /* unreachable */
-            }
-          }
-        }
+        saveOldValue(*phi_v, old_val_map);
       }
     }
 
@@ -492,65 +732,11 @@ struct CrabInterBlockBuilder : public InstVisitor<CrabInterBlockBuilder> {
       if (!isTracked(phi, m_lfac.getCfgBuilderParams())) {
         continue;
       }
-      const Value &v = *phi.getIncomingValueForBlock(&m_inc_BB);
       if (phi.getName().startswith("shadow.mem")) {
         // XXX: ignore PHI shadow mem instructions.
         continue;
       }
-
-      /// Regular PHI node: bool, integer, or pointer
-      crab_lit_ref_t lhs_lit = m_lfac.getLit(phi);
-      if (!lhs_lit || !lhs_lit->isVar()) {
-        CLAM_ERROR("unexpected PHI instruction");
-      }
-      var_t lhs = lhs_lit->getVar();
-      auto it = old_val_map.find(&v);
-      if (it != old_val_map.end()) {
-        // -- use old version if exists
-        if (isBool(phi)) {
-          m_bb.bool_assign(lhs, it->second);
-        } else if (phi.getType()->isIntegerTy()) {
-          m_bb.assign(lhs, it->second);
-        } else if (isReference(phi, m_lfac.getCfgBuilderParams())) {
-          Region rgn_phi = getRegion(m_mem, m_func_regions, m_params, phi, phi);
-          m_bb.gep_ref(lhs, m_lfac.mkRegionVar(rgn_phi), it->second,
-                       m_lfac.mkRegionVar(rgn_phi));
-        }
-      } else {
-        if (crab_lit_ref_t phi_val_lit = m_lfac.getLit(v)) {
-          if (phi_val_lit->isBool()) {
-            if (phi_val_lit->isVar()) {
-              m_bb.bool_assign(lhs, phi_val_lit->getVar());
-            } else {
-              m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_lit)
-                                        ? lin_cst_t::get_true()
-                                        : lin_cst_t::get_false());
-            }
-          } else if (phi_val_lit->isInt()) {
-            m_bb.assign(lhs, m_lfac.getExp(phi_val_lit));
-          } else if (isReference(v, m_params)) {
-            assert(phi_val_lit->isRef());
-            if (phi_val_lit->isVar()) {
-              Region rgn_phi =
-                  getRegion(m_mem, m_func_regions, m_params, phi, phi);
-              Region rgn_phi_v =
-                  getRegion(m_mem, m_func_regions, m_params, phi, v);
-              m_bb.gep_ref(lhs, m_lfac.mkRegionVar(rgn_phi),
-                           phi_val_lit->getVar(),
-                           m_lfac.mkRegionVar(rgn_phi_v));
-            } else {
-              m_bb.havoc(lhs, phi.getName().str() + " := null");
-              m_bb.assume_ref(ref_cst_t::mk_null(lhs));
-            }
-          } else {
-            /* unreachable*/
-          }
-        } else {
-          // we can be here if the incoming value is a bignum and we
-          // don't allow bignums.
-          m_bb.havoc(lhs, valueToStr(phi) + " TODO");
-        }
-      }
+      assignPhi(phi, *phi.getIncomingValueForBlock(&m_inc_BB), old_val_map);
     }
   }
 };
@@ -569,17 +755,67 @@ class MemoryInitializer {
   basic_block_t &m_bb;
   // Used to mark the first array store as strong update.
   RegionSet m_initialized_arrays;
-  // Maximum number of array stores
-  unsigned m_max_stores;
+
+  // Array stores of the same value at consecutive offsets of the same
+  // region. They are added as a single range store.
+  struct StoreRun {
+    Region rgn;
+    number_t val;
+    uint64_t elem_size;
+    // offsets of the first and last stores
+    unsigned lb;
+    unsigned ub;
+  };
+  llvm::Optional<StoreRun> m_run;
+
+  void addArrayStore(Region rgn, unsigned offset, number_t val,
+                     uint64_t elem_size) {
+    if (m_run.hasValue()) {
+      StoreRun &r = m_run.getValue();
+      if (r.rgn == rgn && r.val == val && r.elem_size == elem_size &&
+          r.ub + elem_size == offset) {
+        r.ub = offset;
+        return;
+      }
+      flush();
+    }
+    m_run = StoreRun{rgn, val, elem_size, offset, offset};
+  }
+
+  // Return true if C is a table of integers that must be summarized
+  bool isLargeTable(const ConstantDataSequential &C) const {
+    return m_params.max_global_init_table_size > 0 &&
+           C.getElementType()->isIntegerTy() &&
+           C.getNumElements() > m_params.max_global_init_table_size;
+  }
 
 public:
   MemoryInitializer(crabLitFactory &lfac, HeapAbstraction &mem,
                     RegionSet &func_regions, const DataLayout &dl,
                     const CrabBuilderParams &params, Function &fun,
-                    basic_block_t &bb, unsigned max_stores = -1)
+                    basic_block_t &bb)
 
       : m_lfac(lfac), m_mem(mem), m_func_regions(func_regions), m_dl(dl),
-        m_params(params), m_fun(fun), m_bb(bb), m_max_stores(max_stores) {}
+        m_params(params), m_fun(fun), m_bb(bb) {}
+
+  // Add the pending array stores. It must be called after the last
+  // Init* call.
+  void flush() {
+    if (!m_run.hasValue()) {
+      return;
+    }
+    const StoreRun &r = m_run.getValue();
+    var_t a = m_lfac.mkArrayVar(r.rgn);
+    bool first = m_initialized_arrays.insert(r.rgn).second;
+    m_bb.array_store(a, lin_exp_t(r.lb), r.val, r.elem_size,
+                     first /*strong update*/);
+    if (r.lb != r.ub) {
+      // a[lb+elem_size..ub] := val
+      m_bb.array_store_range(a, lin_exp_t(r.lb + r.elem_size),
+                             lin_exp_t(r.ub), r.val, r.elem_size);
+    }
+    m_run = llvm::None;
+  }
 
   void InitGlobalMemory(Value &Base, Constant &C, unsigned offset) {
     if (isa<ConstantPointerNull>(C) || isa<ConstantFP>(C) ||
@@ -591,6 +827,29 @@ public:
       if (!(CDS->isString() || CDS->isCString())) {
         Type *IndexedType = CDS->getType()->getElementType();
         unsigned ElemOffset = clam::storageSize(IndexedType, m_dl);
+        if (isLargeTable(*CDS)) {
+          // Only the smallest and largest elements are stored. The
+          // rest of the table is unknown except for array smashing
+          // which infers the bounds of all the elements.
+          auto elem = [CDS](unsigned i) -> const APInt & {
+            return cast<ConstantInt>(CDS->getElementAsConstant(i))->getValue();
+          };
+          unsigned min = 0, max = 0;
+          for (unsigned i = 1, e = CDS->getNumElements(); i < e; ++i) {
+            if (elem(i).slt(elem(min))) {
+              min = i;
+            } else if (elem(i).sgt(elem(max))) {
+              max = i;
+            }
+          }
+          InitGlobalMemory(Base, *(CDS->getElementAsConstant(min)),
+                           offset + (min * ElemOffset));
+          if (max != min) {
+            InitGlobalMemory(Base, *(CDS->getElementAsConstant(max)),
+                             offset + (max * ElemOffset));
+          }
+          return;
+        }
         for (unsigned i = 0, e = CDS->getNumElements(); i < e; ++i) {
           InitGlobalMemory(Base, *(CDS->getElementAsConstant(i)),
                            offset + (i * ElemOffset));
@@ -679,15 +938,13 @@ public:
       assert(val_lit);
       uint64_t elem_size = clam::storageSize(Val.getType(), m_dl);
       assert(elem_size > 0);
-      bool first = m_initialized_arrays.insert(rgn).second;
       number_t val(0);
       if (val_lit->isInt()) {
         val = m_lfac.getIntCst(val_lit);
       } else if (val_lit->isBool() && m_lfac.isBoolTrue(val_lit)) {
         val = number_t(1);
       }
-      m_bb.array_store(m_lfac.mkArrayVar(rgn), lin_exp_t(offset), val,
-                       elem_size, first /*strong update*/);
+      addArrayStore(rgn, offset, val, elem_size);
     } else if (m_params.trackMemory()) {
       CLAM_WARNING(
           "TODO implement global initializer if CrabBuilderPrecision::MEM");
@@ -734,6 +991,8 @@ class CrabIntraBlockBuilder : public InstVisitor<CrabIntraBlockBuilder> {
   DenseMap<const statement_t *, const Instruction *> &m_rev_map;
   // HACK: to translate to strong updates with SINGLETON_MEMORY
   RegionSet &m_regions_with_store;
+  // region variables that need initialization
+  RegionInitTracker &m_rgn_init;
   // The map key is a verifier call (assert or assume) and the map
   // value is its parameter. The operands of map value are guaranteed
   // to be integers.
@@ -786,6 +1045,7 @@ class CrabIntraBlockBuilder : public InstVisitor<CrabIntraBlockBuilder> {
   void LoadFromSingletonMem(LoadInst &I, var_t lhs, var_t rhs,
                             Region rhs_region);
   void doCallSite(CallInst &CI);
+  TrackedRegions &getTrackedRegions();
   void doCrabSpecialIntrinsic(CallInst &CI);
 
 public:
@@ -798,7 +1058,7 @@ public:
       basic_block_t *ret_insts, CrabBuilderManagerImpl &man,
       bool &has_seahorn_fail, RegionSet &func_regions, 
       llvm::DenseMap<const statement_t *, const llvm::Instruction *> &rev_map,
-      RegionSet &regions_with_store,
+      RegionSet &regions_with_store, RegionInitTracker &rgn_init,
       DenseMap<const GetElementPtrInst *, var_t> &gep_map,
       DenseMap<CallInst *, CmpInst *> &verif_calls);
 
@@ -832,7 +1092,7 @@ CrabIntraBlockBuilder::CrabIntraBlockBuilder(
     basic_block_t *ret_insts, CrabBuilderManagerImpl &man,
     bool &has_seahorn_fail, RegionSet &func_regions, 
     llvm::DenseMap<const statement_t *, const llvm::Instruction *> &rev_map,
-    RegionSet &regions_with_store,
+    RegionSet &regions_with_store, RegionInitTracker &rgn_init,
     DenseMap<const GetElementPtrInst *, var_t> &gep_map,
     DenseMap<CallInst *, CmpInst *> &verif_calls)
     : m_lfac(lfac), m_as_man(as_man), m_mem(mem), m_dl(dl), m_tli(tli),
@@ -840,7 +1100,8 @@ CrabIntraBlockBuilder::CrabIntraBlockBuilder(
       m_params(params), m_func_globals(func_globals), m_ret_insts(ret_insts),
       m_man(man), m_has_seahorn_fail(has_seahorn_fail),
       m_func_regions(func_regions), m_gep_map(gep_map), m_rev_map(rev_map),
-      m_regions_with_store(regions_with_store), m_verif_calls(verif_calls) {}
+      m_regions_with_store(regions_with_store), m_rgn_init(rgn_init),
+      m_verif_calls(verif_calls) {}
 
 unsigned CrabIntraBlockBuilder::fieldOffset(const StructType *t,
                                             unsigned field) const {
@@ -1373,7 +1634,7 @@ void CrabIntraBlockBuilder::doVerifierCall(CallInst &I) {
           m_bb.assume(lin_cst_t::get_false());
         } else {
           assert(isAssertFn(*callee));
-          m_bb.assertion(lin_cst_t::get_false(), getDebugLoc(&I));
+          insertRevMap(m_bb.assertion(lin_cst_t::get_false(), getDebugLoc(&I)), I);
         }
       }
     }
@@ -1383,7 +1644,7 @@ void CrabIntraBlockBuilder::doVerifierCall(CallInst &I) {
       auto cst_opt = cmpInstToCrabInt(*Cond, m_lfac, isNotAssumeFn(*callee));
       if (cst_opt.hasValue()) {
         if (isAssertFn(*callee)) {
-          m_bb.assertion(cst_opt.getValue(), getDebugLoc(&I));
+          insertRevMap(m_bb.assertion(cst_opt.getValue(), getDebugLoc(&I)), I);
         } else {
           m_bb.assume(cst_opt.getValue());
         }
@@ -1392,7 +1653,7 @@ void CrabIntraBlockBuilder::doVerifierCall(CallInst &I) {
             cmpInstToCrabRef(*Cond, m_lfac, isNotAssumeFn(*callee));
         if (cst_ref_opt.hasValue()) {
           if (isAssertFn(*callee)) {
-            m_bb.assert_ref(cst_ref_opt.getValue(), getDebugLoc(&I));
+            insertRevMap(m_bb.assert_ref(cst_ref_opt.getValue(), getDebugLoc(&I)), I);
           } else {
             m_bb.assume_ref(cst_ref_opt.getValue());
           }
@@ -1414,7 +1675,7 @@ void CrabIntraBlockBuilder::doVerifierCall(CallInst &I) {
           m_bb.bool_assume(v);
         else {
           assert(isAssertFn(*callee));
-          m_bb.bool_assert(v, getDebugLoc(&I));
+          insertRevMap(m_bb.bool_assert(v, getDebugLoc(&I)), I);
         }
       } else if (cond_lit->isInt()) {
 
@@ -1436,7 +1697,7 @@ void CrabIntraBlockBuilder::doVerifierCall(CallInst &I) {
             m_bb.bool_assume(v);
           } else {
             assert(isAssertFn(*callee));
-            m_bb.bool_assert(v, getDebugLoc(&I));
+            insertRevMap(m_bb.bool_assert(v, getDebugLoc(&I)), I);
           }
         } else {
           if (isNotAssumeFn(*callee)) {
@@ -1445,7 +1706,7 @@ void CrabIntraBlockBuilder::doVerifierCall(CallInst &I) {
             m_bb.assume(v >= number_t(1));
           } else {
             assert(isAssertFn(*callee));
-            m_bb.assertion(v >= number_t(1), getDebugLoc(&I));
+            insertRevMap(m_bb.assertion(v >= number_t(1), getDebugLoc(&I)), I);
           }
         }
       }
@@ -1667,8 +1928,8 @@ void CrabIntraBlockBuilder::visitCastInst(CastInst &I) {
           Region rgn_src =
               getRegion(m_mem, m_func_regions, m_params, I, *(I.getOperand(0)));
           Region rgn_dst = getRegion(m_mem, m_func_regions, m_params, I, I);
-          m_bb.gep_ref(dst->getVar(), m_lfac.mkRegionVar(rgn_dst),
-                       src->getVar(), m_lfac.mkRegionVar(rgn_src));
+          m_bb.gep_ref(dst->getVar(), m_rgn_init.mkRegionVar(rgn_dst),
+                       src->getVar(), m_rgn_init.mkRegionVar(rgn_src));
           return;
         }
       }
@@ -1727,6 +1988,8 @@ void CrabIntraBlockBuilder::visitSelectInst(SelectInst &I) {
       if (ci->isOne()) {
         if (op1->isVar()) {
           m_bb.gep_ref(lhs->getVar(), lhs_rgn, op1->getVar(), op1_rgn);
+          m_rgn_init.mayInit(lhs_rgn);
+          m_rgn_init.mayInit(op1_rgn);
         } else {
           assert(m_lfac.isRefNull(op1));
           m_bb.havoc(lhs->getVar());
@@ -1738,6 +2001,8 @@ void CrabIntraBlockBuilder::visitSelectInst(SelectInst &I) {
         }
         if (op2->isVar()) {
           m_bb.gep_ref(lhs->getVar(), lhs_rgn, op2->getVar(), op2_rgn);
+          m_rgn_init.mayInit(lhs_rgn);
+          m_rgn_init.mayInit(op2_rgn);
         } else {
           assert(m_lfac.isRefNull(op2));
           m_bb.havoc(lhs->getVar());
@@ -1753,14 +2018,21 @@ void CrabIntraBlockBuilder::visitSelectInst(SelectInst &I) {
     if (op1->isVar() && op2->isVar()) {
       m_bb.select_ref(lhs->getVar(), lhs_rgn, cond->getVar(), op1->getVar(),
                       op1_rgn, op2->getVar(), op2_rgn);
+      m_rgn_init.mayInit(lhs_rgn);
+      m_rgn_init.mayInit(op1_rgn);
+      m_rgn_init.mayInit(op2_rgn);
 
     } else if (!op1->isVar()) {
       m_bb.select_ref_null_true_value(lhs->getVar(), lhs_rgn, cond->getVar(),
                                       op2->getVar(), op2_rgn);
+      m_rgn_init.mayInit(lhs_rgn);
+      m_rgn_init.mayInit(op2_rgn);
 
     } else if (!op2->isVar()) {
       m_bb.select_ref_null_false_value(lhs->getVar(), lhs_rgn, cond->getVar(),
                                        op1->getVar(), op1_rgn);
+      m_rgn_init.mayInit(lhs_rgn);
+      m_rgn_init.mayInit(op1_rgn);
 
     } else {
       // both op1 and op2 should be null
@@ -1891,7 +2163,7 @@ void CrabIntraBlockBuilder::doAllocFn(Instruction &I) {
     assert(lit->isVar());
     if (isReference(I, m_params)) {
       Region rgn = getRegion(m_mem, m_func_regions, m_params, I, I);
-      m_bb.make_ref(lit->getVar(), m_lfac.mkRegionVar(rgn),
+      m_bb.make_ref(lit->getVar(), m_rgn_init.mkRegionVar(rgn),
 		    m_as_man.mk_tag());
     } else if (isTracked(I, m_params)) {
       // -- havoc return value
@@ -1908,7 +2180,7 @@ void CrabIntraBlockBuilder::doFreeFn(Instruction &I) {
     if (Ptr->isVar() && Ptr->isRef()) {
       Region RgnPtr =
           getRegion(m_mem, m_func_regions, m_params, I, *(CS.getArgument(0)));
-      m_bb.remove_ref(m_lfac.mkRegionVar(RgnPtr), Ptr->getVar());
+      m_bb.remove_ref(m_rgn_init.mkRegionVar(RgnPtr), Ptr->getVar());
     }
   }
 }
@@ -1963,8 +2235,8 @@ void CrabIntraBlockBuilder::doGep(GetElementPtrInst &I,
         if (!base.hasValue()) {
           CRAB_ERROR("doGEP expects a base pointer");
         }
-        var_t crab_rgn = m_lfac.mkRegionVar(rgn);
-        var_t crab_base_rgn = m_lfac.mkRegionVar(base_rgn);
+        var_t crab_rgn = m_rgn_init.mkRegionVar(rgn);
+        var_t crab_base_rgn = m_rgn_init.mkRegionVar(base_rgn);
         m_bb.gep_ref(lhs, crab_rgn, base.getValue(), crab_base_rgn,
                      lin_exp_t(o));
         CRAB_LOG("cfg-gep", crab::outs()
@@ -1989,53 +2261,18 @@ void CrabIntraBlockBuilder::doGep(GetElementPtrInst &I,
   }
 
   // -- translation if symbolic GEP offset
-  // If here, we know that there is at least one non-zero, symbolic index.
-  bool already_assigned = false;
+  // If here, we know that there is at least one non-zero, symbolic
+  // index. All the indexes are folded into a single linear expression
+  // so that only one Crab statement is generated for the whole GEP:
+  // the constant parts are accumulated into the constant of the
+  // expression and each symbolic index contributes one term.
+  lin_exp_t offset(number_t(0));
   for (auto GTI = gep_type_begin(&I), GTE = gep_type_end(&I); GTI != GTE;
        ++GTI) {
     if (const StructType *st = GTI.getStructTypeOrNull()) {
       if (const ConstantInt *ci =
               dyn_cast<const ConstantInt>(GTI.getOperand())) {
-        number_t offset(fieldOffset(st, ci->getZExtValue()));
-        if (lhs.get_type().is_reference()) {
-          // reference statement
-          if (!(already_assigned || base.hasValue())) {
-            CRAB_ERROR("doGEP expects a base pointer");
-          }
-          var_t crab_rgn = m_lfac.mkRegionVar(rgn);
-          var_t crab_base_rgn = m_lfac.mkRegionVar(base_rgn);
-          m_bb.gep_ref(lhs, crab_rgn,
-                       (!already_assigned) ? base.getValue() : lhs,
-                       crab_base_rgn, offset);
-          CRAB_LOG(
-              "cfg-gep",
-              if (!already_assigned) {
-                crab::outs()
-                    << lhs << "=" << base.getValue() << "+" << offset << "\n";
-              } else { crab::outs() << lhs << "+=" << offset << "\n"; });
-        } else if (lhs.get_type().is_integer()) {
-          // pure arithmetic
-          if (!already_assigned) {
-            if (base.hasValue()) {
-              m_bb.assign(lhs, base.getValue() + offset);
-              CRAB_LOG("cfg-gep", crab::outs()
-                                      << "-- " << lhs << ":" << lhs.get_type()
-                                      << "=" << base.getValue() << "+" << offset
-                                      << "\n");
-            } else {
-              m_bb.assign(lhs, offset);
-              CRAB_LOG("cfg-gep", crab::outs()
-                                      << "-- " << lhs << ":" << lhs.get_type()
-                                      << "=" << offset << "\n");
-            }
-          } else {
-            m_bb.add(lhs, lhs, offset);
-            CRAB_LOG("cfg-gep", crab::outs()
-                                    << "-- " << lhs << ":" << lhs.get_type()
-                                    << "+=" << offset << "\n");
-          }
-        }
-        already_assigned = true;
+        offset = offset + number_t(fieldOffset(st, ci->getZExtValue()));
       } else {
         CLAM_ERROR("GEP index expected only to be an integer");
       }
@@ -2053,74 +2290,53 @@ void CrabIntraBlockBuilder::doGep(GetElementPtrInst &I,
         CLAM_ERROR("unexpected GEP index");
       }
 
-      // Signed-extension of the index if needed.
-      llvm::Optional<lin_exp_t> offsetOpt = llvm::None;
-      auto Iidx = std::static_pointer_cast<const crabIntLit>(idx);
-      if (Iidx->isVar()) {
-        unsigned w = Iidx->getBitwidth();
-        assert(w <= max_index_bitwidth);
-        if (w < max_index_bitwidth) {
-          var_t sext_idx = m_lfac.mkIntVar(max_index_bitwidth);
-          m_bb.sext(Iidx->getVar(), sext_idx);
-          offsetOpt = (sext_idx * number_t(storageSize(GTI.getIndexedType())));
-        }
-      }
-      if (!offsetOpt.hasValue()) {
-        offsetOpt =
-            (m_lfac.getExp(idx) * number_t(storageSize(GTI.getIndexedType())));
+      number_t size(storageSize(GTI.getIndexedType()));
+      // Signed-extension of the index only if needed. Otherwise, the
+      // index is used directly without any temporary.
+      if (idx->isVar() && idx->getBitwidth() < max_index_bitwidth) {
+        var_t sext_idx = m_lfac.mkIntVar(max_index_bitwidth);
+        m_bb.sext(idx->getVar(), sext_idx);
+        offset = offset + (sext_idx * size);
+      } else {
+        assert(!idx->isVar() || idx->getBitwidth() == max_index_bitwidth);
+        offset = offset + (m_lfac.getExp(idx) * size);
       }
+    }
+  }
 
-      lin_exp_t offset = offsetOpt.getValue();
-      if (lhs.get_type().is_reference()) {
-        // reference statement
-        if (!(already_assigned || base.hasValue())) {
-          CRAB_ERROR("doGEP expects a base pointer");
-        }
-        var_t crab_rgn = m_lfac.mkRegionVar(rgn);
-        var_t crab_base_rgn = m_lfac.mkRegionVar(base_rgn);
-        m_bb.gep_ref(lhs, crab_rgn, (!already_assigned) ? base.getValue() : lhs,
-                     crab_base_rgn, offset);
-        CRAB_LOG(
-            "cfg-gep",
-            if (!already_assigned) {
-              crab::outs() << lhs << "=" << base.getValue() << "+" << offset
-                           << "\n";
-            } else { crab::outs() << lhs << "+=" << offset << "\n"; });
-      } else if (lhs.get_type().is_integer()) {
-        // pure arithmetic
-        if (!already_assigned) {
-          if (base.hasValue()) {
-            m_bb.assign(lhs, base.getValue() + offset);
-            CRAB_LOG("cfg-gep", crab::outs()
-                                    << "-- " << lhs << ":" << lhs.get_type()
-                                    << "=" << base.getValue() << "+" << offset
-                                    << "\n");
-          } else {
-            m_bb.assign(lhs, offset);
-            CRAB_LOG("cfg-gep", crab::outs()
-                                    << "-- " << lhs << ":" << lhs.get_type()
-                                    << "=" << offset << "\n");
-          }
-        } else {
-          m_bb.assign(lhs, lhs + offset);
-          CRAB_LOG("cfg-gep", crab::outs()
-                                  << "-- " << lhs << ":" << lhs.get_type()
-                                  << "+=" << offset << "\n");
-        }
-      }
-      already_assigned = true;
+  if (lhs.get_type().is_reference()) {
+    // reference statement
+    if (!base.hasValue()) {
+      CRAB_ERROR("doGEP expects a base pointer");
+    }
+    var_t crab_rgn = m_rgn_init.mkRegionVar(rgn);
+    var_t crab_base_rgn = m_rgn_init.mkRegionVar(base_rgn);
+    m_bb.gep_ref(lhs, crab_rgn, base.getValue(), crab_base_rgn, offset);
+    CRAB_LOG("cfg-gep", crab::outs() << "-- " << lhs << ":=" << base.getValue()
+                                     << "+" << offset << "\n");
+  } else if (lhs.get_type().is_integer()) {
+    // pure arithmetic
+    if (base.hasValue()) {
+      m_bb.assign(lhs, base.getValue() + offset);
+      CRAB_LOG("cfg-gep", crab::outs()
+                              << "-- " << lhs << ":" << lhs.get_type()
+                              << ":=" << base.getValue() << "+" << offset
+                              << "\n");
+    } else {
+      m_bb.assign(lhs, offset);
+      CRAB_LOG("cfg-gep", crab::outs() << "-- " << lhs << ":" << lhs.get_type()
+                                       << ":=" << offset << "\n");
     }
   }
 }
 
 /*
- The offset computation is translated to a sequence of Crab linear
- arithmetic operations. In Crab, an arithmetic operation is strongly
- typed which means that all operands must have same bitwidth. GEP
- indexes can have any bitwidth (although fields of struct and vector
- must use always 32 bits). Our solution is to use the same bitwidth
- for all variables in the whole sequence of arithmetic
- operations. This bitwidth is the maximum bitwidth among all GEP
+ The offset computation is translated to a single Crab linear
+ expression. In Crab, an arithmetic operation is strongly typed which
+ means that all operands must have same bitwidth. GEP indexes can
+ have any bitwidth (although fields of struct and vector must use
+ always 32 bits). Our solution is to use the same bitwidth for all
+ variables in the offset expression. This bitwidth is the maximum bitwidth among all GEP
  indices' bitwidths. To generate well-typed Crab operations some of
  the variables are signed extended. If we wouldn't choose the maximum
  bitwidth then we would have truncate operations which can
@@ -2170,7 +2386,7 @@ void CrabIntraBlockBuilder::visitGetElementPtrInst(GetElementPtrInst &I) {
       return;
     }
     assert(ptr->isVar());
-    // Translate GEP as a sequence of arithmetic operations + gep_ref
+    // Translate GEP as a single gep_ref
     doGep(I, bitwidth, lhs->getVar(), ptr->getVar() /*base address*/);
   } else if (m_params.trackOnlySingletonMemory()) {
     Value *Ptr = I.getPointerOperand();
@@ -2201,7 +2417,7 @@ void CrabIntraBlockBuilder::visitGetElementPtrInst(GetElementPtrInst &I) {
       var_t shadowV(m_lfac.getVFac().get(),
                     crab::variable_type(crab::INT_TYPE, bitwidth));
       m_gep_map.insert(std::make_pair(&I, shadowV));
-      // Translate GEP as a sequence of arithmetic operations + assign
+      // Translate GEP as a single assign
       doGep(I, bitwidth, shadowV, baseAddress);
     } else {
       // We give up and translate the GEP to an unconstrained Crab
@@ -2382,10 +2598,10 @@ void CrabIntraBlockBuilder::visitStoreInst(StoreInst &I) {
     if (rgn.isUnknown()) {
       /* untyped region */
       if (val->isVar()) {
-        m_bb.store_to_ref(ptr->getVar(), m_lfac.mkRegionVar(rgn),
+        m_bb.store_to_ref(ptr->getVar(), m_rgn_init.mkRegionVar(rgn),
                           val->getVar());
       } else {
-        m_bb.store_to_ref(ptr->getVar(), m_lfac.mkRegionVar(rgn),
+        m_bb.store_to_ref(ptr->getVar(), m_rgn_init.mkRegionVar(rgn),
                           m_lfac.getTypedConst(val));
       }
 
@@ -2421,7 +2637,7 @@ void CrabIntraBlockBuilder::visitStoreInst(StoreInst &I) {
           m_bb.sext(val->getVar(), ext_or_trunc_val);
         }
 
-        m_bb.store_to_ref(ptr->getVar(), m_lfac.mkRegionVar(rgn),
+        m_bb.store_to_ref(ptr->getVar(), m_rgn_init.mkRegionVar(rgn),
                           ext_or_trunc_val);
       } else { // val is a constant
         auto typed_const = m_lfac.getTypedConst(val);
@@ -2441,7 +2657,7 @@ void CrabIntraBlockBuilder::visitStoreInst(StoreInst &I) {
               "TODO: bitwidth of store value operand different from region");
           return;
         }
-        m_bb.store_to_ref(ptr->getVar(), m_lfac.mkRegionVar(rgn), typed_const);
+        m_bb.store_to_ref(ptr->getVar(), m_rgn_init.mkRegionVar(rgn), typed_const);
       }
     }
   }
@@ -2561,7 +2777,8 @@ void CrabIntraBlockBuilder::visitLoadInst(LoadInst &I) {
 
     if (rgn.isUnknown()) {
       /* untyped region */
-      m_bb.load_from_ref(lhs->getVar(), ptr->getVar(), m_lfac.mkRegionVar(rgn));
+      m_bb.load_from_ref(lhs->getVar(), ptr->getVar(),
+                        m_rgn_init.mkRegionVar(rgn));
     } else {
       /* typed region: we need to make sure that the region's type and
        * the type of the load's lhs match.
@@ -2587,7 +2804,7 @@ void CrabIntraBlockBuilder::visitLoadInst(LoadInst &I) {
         lhs_v = m_lfac.mkIntVar(rgn.getRegionInfo().getType().second);
       }
 
-      m_bb.load_from_ref(lhs_v, ptr->getVar(), m_lfac.mkRegionVar(rgn));
+      m_bb.load_from_ref(lhs_v, ptr->getVar(), m_rgn_init.mkRegionVar(rgn));
 
       if (rgn.getRegionInfo().getType().second < lhs_bitwidth) {
         m_bb.sext(lhs_v, ext_or_trunc_lhs_v);
@@ -2608,7 +2825,7 @@ void CrabIntraBlockBuilder::visitAllocaInst(AllocaInst &I) {
   if (isReference(I, m_params)) {
     crab_lit_ref_t lhs = m_lfac.getLit(I);
     assert(lhs && lhs->isVar());
-    m_bb.make_ref(lhs->getVar(), m_lfac.mkRegionVar(rgn),
+    m_bb.make_ref(lhs->getVar(), m_rgn_init.mkRegionVar(rgn),
 		  m_as_man.mk_tag());
 
     if (m_params.addPointerAssumptions()) {
@@ -2633,6 +2850,7 @@ void CrabIntraBlockBuilder::visitAllocaInst(AllocaInst &I) {
                          *parentF, m_bb);
     Type *ATy = I.getAllocatedType();
     MI.InitZeroInitializer(I, *ATy, 0);
+    MI.flush();
   }
 }
 
@@ -2717,7 +2935,7 @@ void CrabIntraBlockBuilder::visitCallInst(CallInst &I) {
 	Region rgn_lhs = getRegion(m_mem, m_func_regions, m_params, I, I);
 	if (m_params.addPointerAssumptions()) {
           m_bb.intrinsic("unfreed_or_null", {},
-                         {m_lfac.mkRegionVar(rgn_lhs), lhs->getVar()});
+                         {m_rgn_init.mkRegionVar(rgn_lhs), lhs->getVar()});
 	  
 	}
       }
@@ -2727,7 +2945,8 @@ void CrabIntraBlockBuilder::visitCallInst(CallInst &I) {
     // 
     // Note that even if the code is not available for the callee, the
     // pointer analysis might be able to model its pointer semantics.
-    RegionVec inOutRegions = getInputOutputRegions(m_mem, m_params, I);
+    const RegionVec &inOutRegions =
+        getTrackedRegions().getInputOutputRegions(I);
     for (auto rgn : inOutRegions) {
       if (getSingletonValue(rgn, m_params.lower_singleton_aliases))
         m_bb.havoc(m_lfac.mkScalarVar(rgn), "havoc region");
@@ -2803,6 +3022,9 @@ public:
   const basic_block_label_t *
   getCrabBasicBlock(const llvm::BasicBlock *src,
                     const llvm::BasicBlock *dst) const;
+  // return the number of statements at the beginning of the crab
+  // block of bb that model its incoming edge.
+  unsigned getNumFoldedEdgeStatements(const llvm::BasicBlock *bb) const;
   llvm::Optional<var_t> getCrabVariable(const llvm::Value &v);
   llvm::Optional<var_t> getCrabRegionVariable(const llvm::Function &f, const llvm::Value &v);  
   /***** End API to translate LLVM entities to Crab ones *****/
@@ -2843,6 +3065,9 @@ private:
   llvm::Function &m_func;
   // literal factory
   crabLitFactory m_lfac;
+  // region variables that need initialization. It is only needed
+  // while the CFG is built.
+  std::unique_ptr<RegionInitTracker> m_rgn_init;
   tag_manager &m_as_man;
   // heap analysis for memory translation
   HeapAbstraction &m_mem;
@@ -2854,6 +3079,9 @@ private:
   node_to_crab_block_map_t m_node_to_crab_map;
   // map llvm CFG edges to crab basic block ids
   edge_to_crab_block_map_t m_edge_to_crab_map;
+  // map a llvm basic block to the number of statements at the
+  // beginning of its crab block that model its incoming edge.
+  llvm::DenseMap<const llvm::BasicBlock *, unsigned> m_folded_edges;
   // **Unused**: memory regions accessed by m_func
   RegionSet m_func_regions;
   // A fake basic block containing the return instruction and
@@ -2875,6 +3103,8 @@ private:
   // global variables accessed by the function and its callees
   // a pointer in case no globals found for some unexpected reason
   const DenseMap<const Function *, std::vector<const Value *>> &m_globals;
+  // regions of the heap abstraction tracked by the translation
+  TrackedRegions &m_tracked_regions;
   // The manager to access to function declarations of other functions
   CrabBuilderManagerImpl &m_man;
 
@@ -2903,10 +3133,27 @@ private:
   void addBlockInBetween(basic_block_t &src, basic_block_t &dst,
                          basic_block_t &between);
 
+  // Return true if the block of the edge (src,dst) can be folded
+  // into the crab block of dst.
+  bool canFoldEdge(const llvm::BasicBlock &src,
+                   const llvm::BasicBlock &dst) const;
+
+  // Move the statements of edge_bb at the beginning of the crab block
+  // of dst and remove edge_bb.
+  void foldEdge(const llvm::BasicBlock &src, const llvm::BasicBlock &dst,
+                basic_block_t &edge_bb);
+
   basic_block_label_t makeCrabBasicBlockLabel(const llvm::BasicBlock *bb);
 
   basic_block_label_t makeCrabBasicBlockLabel(const llvm::BasicBlock *src,
                                               const llvm::BasicBlock *dst);
+
+public:
+  // Return the function declaration without building the CFG
+  const typename cfg_t::fdecl_t *getFuncDecl() const {
+    return (m_cfg && m_cfg->has_func_decl() ? &m_cfg->get_func_decl()
+                                            : nullptr);
+  }
 }; // end class CfgBuilderImpl
 
 CfgBuilderImpl::~CfgBuilderImpl() {}
@@ -2948,6 +3195,12 @@ CfgBuilderImpl::getCrabBasicBlock(const BasicBlock *src,
   }
 }
 
+unsigned
+CfgBuilderImpl::getNumFoldedEdgeStatements(const BasicBlock *bb) const {
+  auto it = m_folded_edges.find(bb);
+  return (it != m_folded_edges.end() ? it->second : 0);
+}
+
 llvm::Optional<var_t> CfgBuilderImpl::getCrabVariable(const llvm::Value &v) {
   crab_lit_ref_t lit = m_lfac.getLit(v);
   return (lit->isVar() ? llvm::Optional<var_t>(lit->getVar()) : llvm::Optional<var_t>());
@@ -2995,6 +3248,7 @@ void CfgBuilderImpl::initializeGlobalsAtMain(void) {
       MemoryInitializer MI(m_lfac, m_mem, m_func_regions, *m_dl, m_params,
                            m_func, entry);
       MI.InitGlobalMemory(gv, *(gv.getInitializer()), 0);
+      MI.flush();
     }
     // Add assumptions about global addresses
     if (m_params.trackMemory()) {
@@ -3013,7 +3267,7 @@ void CfgBuilderImpl::initializeGlobalsAtMain(void) {
           // TODO: make this user optional
           entry.havoc(gv_lit->getVar(), "C string global variable");
         } else {
-          entry.make_ref(gv_lit->getVar(), m_lfac.mkRegionVar(rgn),
+          entry.make_ref(gv_lit->getVar(), m_rgn_init->mkRegionVar(rgn),
 			 m_as_man.mk_tag());
         }
       }
@@ -3054,7 +3308,7 @@ void CfgBuilderImpl::initializeGlobalsAtMain(void) {
 	crab_lit_ref_t funptr = m_lfac.getLit(F);
 	assert(funptr && funptr->isVar() && funptr->isRef());
 	Region rgn = getRegion(m_mem, m_func_regions, m_params, F, F);
-	entry.make_ref(funptr->getVar(), m_lfac.mkRegionVar(rgn),
+	entry.make_ref(funptr->getVar(), m_rgn_init->mkRegionVar(rgn),
 		       m_as_man.mk_tag());
 	// entry.havoc(funptr->getVar(),
 	//             "Function pointer for " + F.getName().str());
@@ -3085,130 +3339,32 @@ void CfgBuilderImpl::initializeRegions() {
   if (m_lfac.getTrack() != CrabBuilderPrecision::MEM) {
     return;
   }
-  // JN: we could be more efficient and compute all this information
-  // while we translate the instructions but I prefer to keep it
-  // simple for now and do it once the whole CFG has been built.
-  
-  // -- Collect first all regions that might need initialization and
-  // -- those that must not be initialized. 
-  std::set<var_t> mayInitVars, mustNotInitVars;
-  // we need to be careful with region cast statements
-  std::set<var_t> castSrc, castDst;
+  // The statements of the function have been already classified by
+  // m_rgn_init while they were added. Here we only need to add the
+  // regions from the function declaration.
   if (m_cfg->has_func_decl()) {
-    auto const& fdecl = m_cfg->get_func_decl();
-    std::set<var_t> inputs, outputs;
-    std::copy_if(fdecl.get_inputs().begin(), fdecl.get_inputs().end(),
-		 std::inserter(inputs, inputs.end()),
-		 [](const var_t &v) { return v.get_type().is_region();});
-    std::copy_if(fdecl.get_outputs().begin(), fdecl.get_outputs().end(),
-		 std::inserter(outputs, outputs.end()),
-		 [](const var_t &v) { return v.get_type().is_region();});
-
-    mustNotInitVars.insert(inputs.begin(), inputs.end());
+    auto const &fdecl = m_cfg->get_func_decl();
+    for (const var_t &v : fdecl.get_inputs()) {
+      if (v.get_type().is_region()) {
+        m_rgn_init->mustNotInit(v);
+      }
+    }
     // Sometimes we have output regions that are not used in a
     // function. This might happen with functions that allocate memory
     // and return.
-    std::set_difference(outputs.begin(), outputs.end(),
-			inputs.begin(), inputs.end(),
-			std::inserter(mayInitVars, mayInitVars.end()));
-  }
-
-  for (auto bit = m_cfg->begin(), bet = m_cfg->end(); bit!=bet; ++bit) {
-    for (auto it = (*bit).begin(), et = (*bit).end(); it!=et ; ++it) {
-      if ((*it).is_callsite()) {
-	auto s = static_cast<typename basic_block_t::callsite_t*>(&*it);
-	std::set<var_t> inputs, outputs;
-	std::copy_if(s->get_args().begin(), s->get_args().end(),
-		     std::inserter(inputs, inputs.end()),
-		     [](const var_t &v) { return v.get_type().is_region();});
-	std::copy_if(s->get_lhs().begin(), s->get_lhs().end(),
-		     std::inserter(outputs, outputs.end()),
-		     [](const var_t &v) { return v.get_type().is_region();});
-	std::set_difference(outputs.begin(), outputs.end(), inputs.begin(), inputs.end(),
-			    std::inserter(mustNotInitVars, mustNotInitVars.end()));
-	mayInitVars.insert(inputs.begin(), inputs.end());
-      } else if ((*it).is_intrinsic()) {
-	auto s = static_cast<typename basic_block_t::intrinsic_t*>(&*it);
-	using var_or_cst_t = typename basic_block_t::variable_or_constant_t;
-	std::set<var_t> inputs, outputs;
-	for (const typename basic_block_t::variable_or_constant_t &v: s->get_args()) {
-	  if (v.is_variable() && v.get_variable().get_type().is_region()) {
-	    inputs.insert(v.get_variable());
-	  } 
-	}
-	std::copy_if(s->get_lhs().begin(), s->get_lhs().end(),
-		     std::inserter(outputs, outputs.end()),
-		     [](const var_t &v) { return v.get_type().is_region();});
-	std::set_difference(outputs.begin(), outputs.end(), inputs.begin(), inputs.end(),
-			    std::inserter(mustNotInitVars, mustNotInitVars.end()));
-	mayInitVars.insert(inputs.begin(), inputs.end());
-      } else if ((*it).is_ref_make()) { 
-	auto s = static_cast<typename basic_block_t::make_ref_t*>(&*it);
-	mayInitVars.insert(s->region());
-      } else if ((*it).is_ref_remove()) {
-	auto s = static_cast<typename basic_block_t::remove_ref_t*>(&*it);
-	mayInitVars.insert(s->region());      
-      } else if ((*it).is_ref_load()) {
-	auto s = static_cast<typename basic_block_t::load_from_ref_t*>(&*it);
-	mayInitVars.insert(s->region());      
-      } else if ((*it).is_ref_store()) {
-	auto s = static_cast<typename basic_block_t::store_to_ref_t*>(&*it);
-	mayInitVars.insert(s->region());
-      } else if ((*it).is_ref_gep()) {
-	auto s = static_cast<typename basic_block_t::gep_ref_t*>(&*it);
-	mayInitVars.insert(s->lhs_region());
-	mayInitVars.insert(s->rhs_region());            
-      } else if ((*it).is_ref_arr_load()) {
-	auto s = static_cast<typename basic_block_t::load_from_arr_ref_t*>(&*it);
-	mayInitVars.insert(s->region());            
-      } else if ((*it).is_ref_arr_store()) {
-	auto s = static_cast<typename basic_block_t::store_to_arr_ref_t*>(&*it);
-	mayInitVars.insert(s->region());            
-      } else if ((*it).is_ref_select()) {
-	auto s = static_cast<typename basic_block_t::ref_select_t*>(&*it);
-	mayInitVars.insert(s->lhs_rgn());
-	if (s->left_rgn()) {
-	  mayInitVars.insert(*(s->left_rgn()));
-	}
-	if (s->right_rgn()) {
-	  mayInitVars.insert(*(s->right_rgn()));
-	}
-      } else if ((*it).is_ref_to_int()) {
-	auto s = static_cast<typename basic_block_t::ref_to_int_t*>(&*it);
-	mayInitVars.insert(s->region());      
-      } else if ((*it).is_int_to_ref()) {
-	auto s = static_cast<typename basic_block_t::int_to_ref_t*>(&*it);
-	mayInitVars.insert(s->region());            
-      } else if ((*it).is_region_copy()) {
-	auto s = static_cast<typename basic_block_t::region_copy_t*>(&*it);
-	// region_copy are used only for renaming function input
-	// parameters which cannot be initialized.
-	//   mayInitVars.insert(s->rhs_region()); 
-	// The lhs shouldn't be initializated 
-	mustNotInitVars.insert(s->lhs_region());
-      } else if ((*it).is_region_cast()) {
-	auto s = static_cast<typename basic_block_t::region_cast_t*>(&*it);
-	castSrc.insert(s->src());
-	castDst.insert(s->dst());	
+    for (const var_t &v : fdecl.get_outputs()) {
+      if (v.get_type().is_region()) {
+        m_rgn_init->mayInit(v);
       }
     }
   }
 
-  // Do not initialize z in "y := foo(x); cast y to z";  
-  for (auto v: castDst) {
-    if (castSrc.count(v) <= 0) {
-      mustNotInitVars.insert(v);
-    }
-  }
-  
   // Finally, adding Crab region initialization statements
+  std::vector<var_t> rgnVars = m_rgn_init->getRegionsToInit();
   basic_block_t *entry = lookup(m_func.getEntryBlock());
   CRAB_LOG("cfg-mem", llvm::errs() << "Region variables initialized by "
                                    << m_func.getName() << "{";);
-  for (auto it = mayInitVars.rbegin(), et= mayInitVars.rend(); it!=et; ++it) {
-    if (mustNotInitVars.count(*it)) {
-      continue;
-    }
+  for (auto it = rgnVars.rbegin(), et = rgnVars.rend(); it != et; ++it) {
     CRAB_LOG("cfg-mem", crab::errs() << *it << ";";);
     entry->set_insert_point_front();
     entry->region_init(*it);
@@ -3252,6 +3408,30 @@ void CfgBuilderImpl::addBlockInBetween(basic_block_t &src, basic_block_t &dst,
   bb >> dst;
 }
 
+bool CfgBuilderImpl::canFoldEdge(const BasicBlock &src,
+                                 const BasicBlock &dst) const {
+  // The statements of a folded edge are not mapped back so the Crab
+  // CFG optimizations cannot remove or move them.
+  return m_params.fold_edge_blocks && !m_params.simplify &&
+         &src != &dst && dst.getSinglePredecessor() == &src;
+}
+
+void CfgBuilderImpl::foldEdge(const BasicBlock &src, const BasicBlock &dst,
+                              basic_block_t &edge_bb) {
+  basic_block_t *crab_dst = lookup(dst);
+  assert(crab_dst);
+  // dst has only one predecessor so the statements of the edge can
+  // be executed at the entry of dst. They are idempotent because
+  // they cannot read a PHI node of dst. Thus, replaying the crab
+  // block of dst from the invariant after them is still sound.
+  crab_dst->copy_front(edge_bb);
+  m_folded_edges[&dst] = std::distance(edge_bb.begin(), edge_bb.end());
+  basic_block_label_t edge_label = edge_bb.label();
+  m_edge_to_crab_map.erase({&src, &dst});
+  m_cfg->remove(edge_label);
+  addEdge(src, dst);
+}
+
 basic_block_label_t
 CfgBuilderImpl::makeCrabBasicBlockLabel(const BasicBlock *bb) {
   ++m_id;
@@ -3260,19 +3440,11 @@ CfgBuilderImpl::makeCrabBasicBlockLabel(const BasicBlock *bb) {
   return res;
 }
 
-static std::string createBasicBlockName(unsigned id, std::string prefix = "") {
-  if (prefix == "")
-    prefix = std::string("__@bb_");
-  std::string id_str = std::to_string(id);
-  return prefix + id_str;
-}
-
 basic_block_label_t
 CfgBuilderImpl::makeCrabBasicBlockLabel(const BasicBlock *src,
                                         const BasicBlock *dst) {
   ++m_id;
-  std::string name = createBasicBlockName(m_id);
-  basic_block_label_t res(src, dst, name, m_id);
+  basic_block_label_t res(src, dst, m_id);
   m_edge_to_crab_map.insert({{src, dst}, res});
   return res;
 }
@@ -3349,16 +3521,97 @@ basic_block_t *CfgBuilderImpl::execEdge(const BasicBlock &src,
   } else if (const SwitchInst *SI = dyn_cast<SwitchInst>(src.getTerminator())) {
     // switch <value>, label <defaultdest> [ <val>, label <dest> ... ]
     //
-    // TODO: we do not translate precisely switch instructions. We
-    // simply add an edge from src to dest.
+    // A new block between src and dst is added:
+    // - if dst is the default destination, the block assumes that
+    //   value is different from all case values whose destination is
+    //   not dst.
+    // - else the case values whose destination is dst are grouped
+    //   into maximal ranges [lo,hi] of contiguous values. If there is
+    //   only one range then the block assumes that value is in
+    //   [lo,hi]. Otherwise, one block per range that assumes it is
+    //   inserted between src and the new block so the disjunction of
+    //   the ranges is kept.
+    crab_lit_ref_t cond = m_lfac.getLit(*SI->getCondition());
+    if (!cond || !cond->isInt() || !cond->isVar()) {
+      addEdge(src, dst);
+      return nullptr;
+    }
+    basic_block_t *crab_src = lookup(src);
+    basic_block_t *crab_dst = lookup(dst);
+    assert(crab_src && crab_dst);
 
-    // To be precise, we need to create a block between src and dest
-    // and add the statement "assume(value == val)" if dest is not
-    // the default block. For the default block, we need to add the
-    // sequence:
-    //      "assume(value != val1); ... ; assume(value != valk);"
+    // Create a new crab block that represents the LLVM edge
+    auto bb_label = makeCrabBasicBlockLabel(&src, &dst);
+    basic_block_t &bb = m_cfg->insert(bb_label);
+    addBlockInBetween(*crab_src, *crab_dst, bb);
 
-    addEdge(src, dst);
+    lin_exp_t x(cond->getVar());
+    if (SI->getDefaultDest() == &dst) {
+      for (auto &C : SI->cases()) {
+        if (C.getCaseSuccessor() == &dst) {
+          continue;
+        }
+        crab_lit_ref_t val = m_lfac.getLit(*C.getCaseValue());
+        if (val && val->isInt() && val->isConst()) {
+          bb.assume(lin_cst_t(x != val->getExp()));
+        }
+      }
+    } else {
+      std::vector<number_t> vals;
+      bool all_known = true;
+      for (auto &C : SI->cases()) {
+        if (C.getCaseSuccessor() != &dst) {
+          continue;
+        }
+        crab_lit_ref_t val = m_lfac.getLit(*C.getCaseValue());
+        if (!val || !val->isInt() || !val->isConst()) {
+          // e.g., a bignum case value
+          all_known = false;
+          break;
+        }
+        vals.push_back(val->getInt());
+      }
+      if (all_known && !vals.empty()) {
+        // case values are unique
+        std::sort(vals.begin(), vals.end());
+        std::vector<std::pair<number_t, number_t>> ranges;
+        for (auto &n : vals) {
+          if (!ranges.empty() && ranges.back().second + number_t(1) == n) {
+            ranges.back().second = n;
+          } else {
+            ranges.push_back({n, n});
+          }
+        }
+        auto assumeRange = [&x](basic_block_t &b,
+                                const std::pair<number_t, number_t> &r) {
+          if (r.first == r.second) {
+            b.assume(lin_cst_t(x == r.first));
+          } else {
+            b.assume(lin_cst_t(x >= r.first));
+            b.assume(lin_cst_t(x <= r.second));
+          }
+        };
+        if (ranges.size() == 1) {
+          assumeRange(bb, ranges.front());
+        } else {
+          // Several cases reach dst so this edge is never folded
+          // (dst has not a single predecessor).
+          *crab_src -= bb;
+          for (auto &r : ranges) {
+            // These blocks are also labeled with the LLVM edge but
+            // only bb is mapped to it. The edge is infeasible only
+            // if all its ranges are.
+            ++m_id;
+            basic_block_label_t range_label(&src, &dst, m_id);
+            basic_block_t &range_bb = m_cfg->insert(range_label);
+            *crab_src >> range_bb;
+            range_bb >> bb;
+            assumeRange(range_bb, r);
+          }
+        }
+      }
+    }
+    return &bb;
   }
   return nullptr;
 }
@@ -3464,11 +3717,6 @@ void CfgBuilderImpl::buildCfg() {
 
   const TargetLibraryInfo *tli = (m_tli ? &m_tli->getTLI(m_func) : nullptr);
 
-  // Sanity check: pass NameValues must have been executed before
-  if (!checkAllDefinitionsHaveNames(m_func)) {
-    CLAM_ERROR("All blocks and definitions must have a name");
-  }
-
   // Create a Crab basic block for each LLVM block
   for (auto &B : m_func) {
     addBlock(B);
@@ -3488,6 +3736,7 @@ void CfgBuilderImpl::buildCfg() {
 			    *bb, *entry_bb, m_params, m_globals,
                             m_ret_insts, m_man, has_seahorn_fail,
                             m_func_regions, m_rev_map, regions_with_store,
+                            *m_rgn_init,
                             gep_map, verif_calls);
 
     v.visit(B);
@@ -3495,10 +3744,17 @@ void CfgBuilderImpl::buildCfg() {
     // process the rest of basic blocks
     std::vector<const BasicBlock *> succs_vector(succs(B).begin(),
                                                  succs(B).end());
-    // The default destination of a switch instruction does not
-    // count as a successor but we want to consider it as a such.
-    if (SwitchInst *SI = dyn_cast<SwitchInst>(B.getTerminator())) {
-      succs_vector.push_back(SI->getDefaultDest());
+    // Several cases of a switch instruction (including the default
+    // one) can have the same destination but execEdge adds only one
+    // block per LLVM edge.
+    if (isa<SwitchInst>(B.getTerminator())) {
+      SmallPtrSet<const BasicBlock *, 16> seen;
+      succs_vector.erase(
+          std::remove_if(succs_vector.begin(), succs_vector.end(),
+                         [&seen](const BasicBlock *dst) {
+                           return !seen.insert(dst).second;
+                         }),
+          succs_vector.end());
     }
     for (const BasicBlock *dst : succs_vector) {
       // -- move branch condition in bb to a new block inserted
@@ -3510,7 +3766,8 @@ void CfgBuilderImpl::buildCfg() {
       // -- phi nodes in dst are translated into assignments in
       //    the predecessor
       CrabInterBlockBuilder v(m_lfac, m_mem, m_func_regions, *m_dl,
-                              (tmp_mid_bb ? *tmp_mid_bb : *bb), B, m_params);
+                              (tmp_mid_bb ? *tmp_mid_bb : *bb), B, m_params,
+                              *m_rgn_init);
       v.visit(const_cast<BasicBlock &>(*dst));
 
       if (tmp_mid_bb) {
@@ -3521,6 +3778,9 @@ void CfgBuilderImpl::buildCfg() {
 	} else {
 	  mid_bb->copy_back(*tmp_mid_bb);	  
 	} 
+	if (canFoldEdge(B, *dst)) {
+	  foldEdge(B, *dst, *mid_bb);
+	}
       }
     }
   }
@@ -3562,6 +3822,8 @@ void CfgBuilderImpl::buildCfg() {
   ///
   // This must be called after the CFG has been already constructed.
   initializeRegions();
+  // no more region variables are added
+  m_rgn_init.reset();
 
   if (m_params.simplify) {
     // -- Remove dead statements generated by our translation
@@ -3648,8 +3910,8 @@ void CfgBuilderImpl::addFunctionDeclaration() {
        Region inputRgn = getRegion(m_mem, m_func_regions, m_params, m_func, inputVal);
        if (!getSingletonValue(inputRgn, m_params.lower_singleton_aliases)) {
 	 var_t inputPrime = m_lfac.mkRefVar();
-	 bb.gep_ref(inputVar, m_lfac.mkRegionVar(inputRgn),
-		       inputPrime, m_lfac.mkRegionVar(inputRgn));
+	 bb.gep_ref(inputVar, m_rgn_init->mkRegionVar(inputRgn),
+		       inputPrime, m_rgn_init->mkRegionVar(inputRgn));
 	 inputs.push_back(inputPrime);
        }
      } else if (inputVar.get_type().is_array()) {
@@ -3682,7 +3944,11 @@ void CfgBuilderImpl::addFunctionDeclaration() {
   };
   auto translateInputRegionAsRegion = [this,&inputs](const Region &inputRgn, basic_block_t &bb) {
      var_t inputPrime = m_lfac.mkRegionVar(inputRgn.getRegionInfo());
-     bb.region_copy(m_lfac.mkRegionVar(inputRgn), inputPrime);
+     var_t inputVar = m_lfac.mkRegionVar(inputRgn);
+     bb.region_copy(inputVar, inputPrime);
+     // region_copy are used only for renaming function input
+     // parameters which cannot be initialized.
+     m_rgn_init->mustNotInit(inputVar);
      inputs.push_back(inputPrime);
   };
   
@@ -3772,9 +4038,10 @@ void CfgBuilderImpl::addFunctionDeclaration() {
     }
 
   
-    RegionVec inRegions = getInputRegions(m_mem, m_params, m_func);
-    RegionVec inOutRegions = getInputOutputRegions(m_mem, m_params, m_func);
-    RegionVec outRegions = getOutputRegions(m_mem, m_params, m_func);
+    const RegionVec &inRegions = m_tracked_regions.getInputRegions(m_func);
+    const RegionVec &inOutRegions =
+        m_tracked_regions.getInputOutputRegions(m_func);
+    const RegionVec &outRegions = m_tracked_regions.getOutputRegions(m_func);
 
     CRAB_LOG("cfg-mem", llvm::errs()
                             << "Function " << m_func.getName()
@@ -3842,7 +4109,9 @@ void CfgBuilderImpl::addFunctionDeclaration() {
       } else if (m_params.trackMemory()) {
         // input version
         var_t rgn_in = m_lfac.mkRegionVar(rgn.getRegionInfo());
-        tmp_bb1->region_copy(m_lfac.mkRegionVar(rgn), rgn_in);
+        var_t rgn_var = m_lfac.mkRegionVar(rgn);
+        tmp_bb1->region_copy(rgn_var, rgn_in);
+        m_rgn_init->mustNotInit(rgn_var);
         inputs.push_back(rgn_in);
         // output version
         outputs.push_back(m_lfac.mkRegionVar(rgn));
@@ -3934,6 +4203,9 @@ void CrabBuilderParams::write(raw_ostream &o) const {
     << "\n";
   o << "\tadd pointer assumptions: " << addPointerAssumptions() << "\n";
   o << "\tenable big numbers: " << enable_bignums << "\n";
+  o << "\tminimize phi copies: " << minimize_phi_copies << "\n";
+  o << "\tfold edge blocks: " << fold_edge_blocks << "\n";
+  o << "\tmax size of global tables: " << max_global_init_table_size << "\n";
 }
 
 /* CFG Builder class */
@@ -3959,6 +4231,11 @@ CfgBuilder::getCrabBasicBlock(const llvm::BasicBlock *src,
   return m_impl->getCrabBasicBlock(src, dst);
 }
 
+unsigned
+CfgBuilder::getNumFoldedEdgeStatements(const llvm::BasicBlock *bb) const {
+  return m_impl->getNumFoldedEdgeStatements(bb);
+}
+
 llvm::Optional<var_t> CfgBuilder::getCrabVariable(const llvm::Value &v) {
   return m_impl->getCrabVariable(v);
 }
@@ -4029,6 +4306,14 @@ public:
 
   CfgBuilderPtr getCfgBuilder(const llvm::Function &f) const;
 
+  void resetCfgBuilder(const llvm::Function &f);
+
+  void releaseCfgBuilder(const llvm::Function &f);
+
+  // Return the crab function declaration of f without building its
+  // CFG, or nullptr if none. It is available even if f was released.
+  const typename cfg_t::fdecl_t *getFuncDecl(const llvm::Function &f) const;
+
   variable_factory_t &getVarFactory();
 
   tag_manager &getAllocSiteMan();
@@ -4040,11 +4325,15 @@ public:
 
   HeapAbstraction &getHeapAbstraction();
 
+  TrackedRegions &getTrackedRegions() { return m_tracked_regions; }
+
 private:
   // User-definable parameters for building the Crab CFGs
   CrabBuilderParams m_params;
   // Map LLVM function to Crab CfgBuilder
   llvm::DenseMap<const llvm::Function *, CfgBuilderPtr> m_cfg_builder_map;
+  // Functions whose builders only keep their declarations
+  llvm::DenseSet<const llvm::Function *> m_released;
   // Used for the translation from bitcode to Crab CFG
   llvm::TargetLibraryInfoWrapperPass &m_tli;
   // All CFGs created by this manager are created using the same
@@ -4053,6 +4342,8 @@ private:
   tag_manager m_as_man;
   // Whole-program heap analysis
   std::unique_ptr<HeapAbstraction> m_mem;
+  // Regions of m_mem tracked with m_params
+  TrackedRegions m_tracked_regions;
   // Global variables accessed by the function and its callees
   friend class CfgBuilderImpl; // to access to m_globals
   llvm::DenseMap<const llvm::Function *, std::vector<const llvm::Value *>>
@@ -4062,7 +4353,8 @@ private:
 CrabBuilderManagerImpl::CrabBuilderManagerImpl(
     CrabBuilderParams params, llvm::TargetLibraryInfoWrapperPass &tli,
     std::unique_ptr<HeapAbstraction> mem)
-    : m_params(params), m_tli(tli), m_mem(std::move(mem)) {
+    : m_params(params), m_tli(tli), m_mem(std::move(mem)),
+      m_tracked_regions(*m_mem, m_params) {
   CRAB_VERBOSE_IF(1, m_params.write(llvm::errs()));
 }
 
@@ -4124,6 +4416,7 @@ CfgBuilderPtr CrabBuilderManagerImpl::mkCfgBuilder(const Function &f) {
   if (it != m_cfg_builder_map.end()) {
     auto builder = it->second;
     builder->buildCfg();
+    m_released.erase(&f);
     return builder;
   } else {
     CLAM_ERROR("Not found cfg builder for " << f.getName());
@@ -4131,7 +4424,8 @@ CfgBuilderPtr CrabBuilderManagerImpl::mkCfgBuilder(const Function &f) {
 }
 
 bool CrabBuilderManagerImpl::hasCfg(const Function &f) const {
-  return m_cfg_builder_map.find(&f) != m_cfg_builder_map.end();
+  return m_cfg_builder_map.find(&f) != m_cfg_builder_map.end() &&
+         !m_released.count(&f);
 }
 
 cfg_t &CrabBuilderManagerImpl::getCfg(const Function &f) const {
@@ -4146,6 +4440,37 @@ CfgBuilderPtr CrabBuilderManagerImpl::getCfgBuilder(const Function &f) const {
   return it->second;
 }
 
+void CrabBuilderManagerImpl::resetCfgBuilder(const Function &f) {
+  if (f.empty()) {
+    return;
+  }
+  // The CFG is built lazily but the function declaration must be
+  // available for the callsites of f.
+  CfgBuilderPtr builder(new CfgBuilder(f, *this));
+  builder->addFunctionDeclaration();
+  m_cfg_builder_map[&f] = builder;
+  m_released.erase(&f);
+}
+
+void CrabBuilderManagerImpl::releaseCfgBuilder(const Function &f) {
+  if (!hasCfg(f)) {
+    return;
+  }
+  // A fresh builder only has the function declaration. The old
+  // builder is freed once its last user is gone.
+  resetCfgBuilder(f);
+  m_released.insert(&f);
+}
+
+const typename cfg_t::fdecl_t *
+CrabBuilderManagerImpl::getFuncDecl(const Function &f) const {
+  auto it = m_cfg_builder_map.find(&f);
+  if (it == m_cfg_builder_map.end()) {
+    return nullptr;
+  }
+  return it->second->m_impl->getFuncDecl();
+}
+
 variable_factory_t &CrabBuilderManagerImpl::getVarFactory() { return m_vfac; }
 
 tag_manager &CrabBuilderManagerImpl::getAllocSiteMan() { return m_as_man; }
@@ -4178,6 +4503,10 @@ HeapAbstraction &CrabBuilderManagerImpl::getHeapAbstraction() { return *m_mem; }
  *    - a_i1,...,a_in are read-only and modified regions by foo.
  *    - a_o1,...,a_om are modified and new regions created inside foo.
  **/
+TrackedRegions &CrabIntraBlockBuilder::getTrackedRegions() {
+  return m_man.getTrackedRegions();
+}
+
 void CrabIntraBlockBuilder::doCallSite(CallInst &I) {
   CallSite CS(&I);
   const Function *calleeF =
@@ -4252,9 +4581,10 @@ void CrabIntraBlockBuilder::doCallSite(CallInst &I) {
 
   // -- add the input and output parameters a_i1,...,a_in
   // -- and a_o1,...,a_om.
-  RegionVec inRegions = getInputRegions(m_mem, m_params, I);
-  RegionVec inOutRegions = getInputOutputRegions(m_mem, m_params, I);
-  RegionVec outRegions = getOutputRegions(m_mem, m_params, I);
+  TrackedRegions &tracked = getTrackedRegions();
+  const RegionVec &inRegions = tracked.getInputRegions(I);
+  const RegionVec &inOutRegions = tracked.getInputOutputRegions(I);
+  const RegionVec &outRegions = tracked.getOutputRegions(I);
 
   CRAB_LOG("cfg-mem", llvm::errs()
                           << "Callsite " << I << "\n"
@@ -4310,13 +4640,7 @@ void CrabIntraBlockBuilder::doCallSite(CallInst &I) {
   }
 
   // -- Sanity checks if function declaration of the callee is available
-  const typename cfg_t::fdecl_t *calleeF_decl = nullptr;
-  if (m_man.hasCfg(*calleeF)) {
-    auto &callee_cfg = m_man.getCfg(*calleeF);
-    if (callee_cfg.has_func_decl()) {
-      calleeF_decl = &callee_cfg.get_func_decl();
-    }
-  }
+  const typename cfg_t::fdecl_t *calleeF_decl = m_man.getFuncDecl(*calleeF);
 
   auto hasCompatibleTypes = [](const typename var_t::type_t &t1,
 			       const typename var_t::type_t &t2) {
@@ -4467,21 +4791,27 @@ void CrabIntraBlockBuilder::doCallSite(CallInst &I) {
     std::vector<var_or_cst_t> new_inputs;
     std::copy(inputs.begin(), inputs.end(), std::back_inserter(new_inputs)); 
     m_bb.intrinsic(name, outputs, new_inputs);
+    m_rgn_init.call(outputs, inputs);
   } else {
     if (m_params.trackMemory()) {
       for (unsigned i = 0, sz = pendingInRgnCasts.size(); i < sz; ++i) {
 	m_bb.region_cast(pendingInRgnCasts[i].first,
 	 		 pendingInRgnCasts[i].second);
+	m_rgn_init.cast(pendingInRgnCasts[i].first,
+			pendingInRgnCasts[i].second);
 			 
       }
     }
 
     m_bb.callsite(calleeF->getName().str(), outputs, inputs);
+    m_rgn_init.call(outputs, inputs);
 
     if (m_params.trackMemory()) {    
       for (unsigned i = 0, sz = pendingOutRgnCasts.size(); i < sz; ++i) {
 	m_bb.region_cast(pendingOutRgnCasts[i].second,
 	 		 pendingOutRgnCasts[i].first);
+	m_rgn_init.cast(pendingOutRgnCasts[i].second,
+			pendingOutRgnCasts[i].first);
       }
     }
   }
@@ -4560,7 +4890,7 @@ void CrabIntraBlockBuilder::doCrabSpecialIntrinsic(CallInst &I) {
       // initially allocated and they cannot be deallocated.
       m_bb.havoc(outParamLit->getVar(), valueToStr(I));
     } else {
-      var_t rgnVar = m_lfac.mkRegionVar(rgn);
+      var_t rgnVar = m_rgn_init.mkRegionVar(rgn);
       std::vector<var_or_cst_t> inputs{rgnVar, refParamLit->getVar()};
       std::vector<var_t> outputs {outParamLit->getVar()};
       m_bb.intrinsic(name, outputs, inputs);
@@ -4581,7 +4911,7 @@ void CrabIntraBlockBuilder::doCrabSpecialIntrinsic(CallInst &I) {
 
     Region rgn = getRegion(m_mem, m_func_regions, m_params, I, *Ptr);
     if (!getSingletonValue(rgn, m_params.lower_singleton_aliases)) {    
-      var_t rgnVar = m_lfac.mkRegionVar(rgn);
+      var_t rgnVar = m_rgn_init.mkRegionVar(rgn);
       std::vector<var_or_cst_t> inputs{rgnVar, refParamLit->getVar()};
       std::vector<var_t> outputs;
       m_bb.intrinsic(name, outputs, inputs);
@@ -4607,7 +4937,7 @@ void CrabIntraBlockBuilder::doCrabSpecialIntrinsic(CallInst &I) {
 
     Region rgn = getRegion(m_mem, m_func_regions, m_params, I, *Ptr);
     if (!getSingletonValue(rgn, m_params.lower_singleton_aliases)) {        
-      var_t rgnVar = m_lfac.mkRegionVar(rgn);
+      var_t rgnVar = m_rgn_init.mkRegionVar(rgn);
       std::vector<var_or_cst_t> inputs{rgnVar, refParamLit->getVar(),
 				       var_or_cst_t(m_lfac.getIntCst(tagParamLit),
 						    crab::variable_type(INT_TYPE, 32))};
@@ -4643,7 +4973,7 @@ void CrabIntraBlockBuilder::doCrabSpecialIntrinsic(CallInst &I) {
       // -crab-singleton-aliases.
       m_bb.havoc(outParam, valueToStr(I));
     } else {
-      var_t rgnVar = m_lfac.mkRegionVar(rgn);
+      var_t rgnVar = m_rgn_init.mkRegionVar(rgn);
       std::vector<var_or_cst_t> inputs{rgnVar, ptrParamLit->getVar(),
 				       var_or_cst_t(m_lfac.getIntCst(tagParamLit),
 						    crab::variable_type(INT_TYPE, 32))};
@@ -4667,11 +4997,13 @@ CfgBuilderImpl::CfgBuilderImpl(const Function &func,
       // Builder never modifies the bitcode.
       m_func(const_cast<Function &>(func)),
       m_lfac(man.getVarFactory(), man.getCfgBuilderParams()),
+      m_rgn_init(new RegionInitTracker(m_lfac)),
       m_as_man(man.getAllocSiteMan()),
       m_mem(man.getHeapAbstraction()), m_cfg(nullptr), m_id(0),
       m_dl(&(func.getParent()->getDataLayout())), m_tli(&(man.getTLIWrapper())),
       m_params(man.getCfgBuilderParams()), m_globals(man.m_globals),
-      m_ret_insts(nullptr), m_man(man) {
+      m_tracked_regions(man.getTrackedRegions()), m_ret_insts(nullptr),
+      m_man(man) {
   m_cfg =
       std::make_unique<cfg_t>(makeCrabBasicBlockLabel(&m_func.getEntryBlock()));
   setExitBlock();
@@ -4702,6 +5034,14 @@ CfgBuilderPtr CrabBuilderManager::getCfgBuilder(const Function &f) const {
   return m_impl->getCfgBuilder(f);
 }
 
+void CrabBuilderManager::resetCfgBuilder(const Function &f) {
+  m_impl->resetCfgBuilder(f);
+}
+
+void CrabBuilderManager::releaseCfgBuilder(const Function &f) {
+  m_impl->releaseCfgBuilder(f);
+}
+
 variable_factory_t &CrabBuilderManager::getVarFactory() {
   return m_impl->getVarFactory();
 }
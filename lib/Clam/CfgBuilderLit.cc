@@ -4,7 +4,9 @@
 #include "clam/Support/Debug.hh"
 #include "clam/crab/crab_lang.hh"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/Support/Allocator.h"
 
 namespace clam {
 
@@ -51,7 +53,7 @@ public:
   // Create an scalar variable associated with region rgn.
   var_t mkScalarVar(Region rgn);
 
-  // Unsafe common accessors to crab_lit_ref_t subclasses.
+  // Common accessors to crab_lit_ref_t that check the literal kind.
   bool isBoolTrue(const crab_lit_ref_t ref) const;
 
   bool isBoolFalse(const crab_lit_ref_t ref) const;
@@ -65,7 +67,8 @@ public:
   lin_exp_t getExp(const crab_lit_ref_t ref) const;
 
 private:
-  using lit_cache_t = std::unordered_map<const llvm::Value *, crab_lit_ref_t>;
+  // A null entry means that the value cannot be translated.
+  using lit_cache_t = llvm::DenseMap<const llvm::Value *, crab_lit_ref_t>;
   // We need this ordering for caching regions because the same
   // region's id can appear with two different types so we need to
   // treat them as different variables.
@@ -83,12 +86,14 @@ private:
 
   llvm_variable_factory &m_vfac;
   const CrabBuilderParams &m_params;
+  // Owner of all literals created by the factory
+  llvm::SpecificBumpPtrAllocator<crabLit> m_lit_arena;
   lit_cache_t m_lit_cache;
   rgn_cache_t m_rgn_cache;
 
-  llvm::Optional<crabBoolLit> getBoolLit(const llvm::Value &v);
-  llvm::Optional<crabIntLit> getIntLit(const llvm::Value &v);
-  llvm::Optional<crabRefLit> getRefLit(const llvm::Value &v);
+  llvm::Optional<crabLit> getBoolLit(const llvm::Value &v);
+  llvm::Optional<crabLit> getIntLit(const llvm::Value &v);
+  llvm::Optional<crabLit> getRefLit(const llvm::Value &v);
 
   crab::variable_type regionTypeToCrabType(RegionInfo rgnInfo);
 };
@@ -106,32 +111,20 @@ crab_lit_ref_t crabLitFactoryImpl::getLit(const Value &v) {
   // Note that getBoolLit, getRefLit and getIntLit are not aware of
   // which types are tracked or not. They only use type information
   // and not the track level.
+  Optional<crabLit> lit;
   if (isBool(&t)) {
-    Optional<crabBoolLit> lit = getBoolLit(v);
-    if (lit.hasValue()) {
-      crab_lit_ref_t ref = std::static_pointer_cast<crabLit>(
-          std::make_shared<crabBoolLit>(lit.getValue()));
-      m_lit_cache.insert({&v, ref});
-      return ref;
-    }
+    lit = getBoolLit(v);
   } else if (isInteger(&t)) {
-    Optional<crabIntLit> lit = getIntLit(v);
-    if (lit.hasValue()) {
-      crab_lit_ref_t ref = std::static_pointer_cast<crabLit>(
-          std::make_shared<crabIntLit>(lit.getValue()));
-      m_lit_cache.insert({&v, ref});
-      return ref;
-    }
+    lit = getIntLit(v);
   } else if (t.isPointerTy()) {
-    Optional<crabRefLit> lit = getRefLit(v);
-    if (lit.hasValue()) {
-      crab_lit_ref_t ref = std::static_pointer_cast<crabLit>(
-          std::make_shared<crabRefLit>(lit.getValue()));
-      m_lit_cache.insert({&v, ref});
-      return ref;
-    }
+    lit = getRefLit(v);
   }
-  return nullptr;
+  crab_lit_ref_t ref = nullptr;
+  if (lit.hasValue()) {
+    ref = new (m_lit_arena.Allocate()) crabLit(lit.getValue());
+  }
+  m_lit_cache.insert({&v, ref});
+  return ref;
 }
 
 var_t crabLitFactoryImpl::mkArrayVar(Region rgn) {
@@ -295,106 +288,81 @@ Optional<var_t> crabLitFactoryImpl::mkVar(const Value &v) {
 bool crabLitFactoryImpl::isBoolTrue(const crab_lit_ref_t ref) const {
   if (!ref || !ref->isBool())
     CLAM_ERROR("Literal is not a Boolean");
-  auto lit = std::static_pointer_cast<const crabBoolLit>(ref);
-  return lit->isTrue();
+  return ref->isTrue();
 }
 
 bool crabLitFactoryImpl::isBoolFalse(const crab_lit_ref_t ref) const {
   if (!ref || !ref->isBool())
     CLAM_ERROR("Literal is not a Boolean");
-  auto lit = std::static_pointer_cast<const crabBoolLit>(ref);
-  return lit->isFalse();
+  return ref->isFalse();
 }
 
 bool crabLitFactoryImpl::isRefNull(const crab_lit_ref_t ref) const {
   if (!ref || !ref->isRef())
     CLAM_ERROR("Literal is not a pointer");
-  auto lit = std::static_pointer_cast<const crabRefLit>(ref);
-  return lit->isNull();
+  return ref->isNull();
 }
 
 var_or_cst_t crabLitFactoryImpl::getTypedConst(const crab_lit_ref_t ref) const {
-  if (ref->isBool()) {
-    auto b = std::static_pointer_cast<const crabBoolLit>(ref);
-    if (b->isConst()) {
-      return b->getTypedConst();
-    } else {
-      CLAM_ERROR("Called getTypedConst on a non-constant literal");
-    }
-  } else if (ref->isInt()) {
-    auto i = std::static_pointer_cast<const crabIntLit>(ref);
-    if (i->isInt()) {
-      return i->getTypedConst();
-    } else {
-      CLAM_ERROR("Called getTypedConst on a non-constant literal");
-    }
-  } else if (ref->isRef()) {
-    auto r = std::static_pointer_cast<const crabRefLit>(ref);
-    if (r->isNull()) {
-      return r->getTypedConst();
-    } else {
-      CLAM_ERROR("called getTypedConst on a non-constant literal");
-    }
-  } else { /*unreachable*/
-    CLAM_ERROR("called getTypedConst on an unexpected literal");
+  if (!ref || !ref->isConst()) {
+    CLAM_ERROR("Called getTypedConst on a non-constant literal");
   }
+  return ref->getTypedConst();
 }
 
 lin_exp_t crabLitFactoryImpl::getExp(const crab_lit_ref_t ref) const {
   if (!ref || !ref->isInt())
     CLAM_ERROR("Literal is not an integer");
-  auto lit = std::static_pointer_cast<const crabIntLit>(ref);
-  return lit->getExp();
+  return ref->getExp();
 }
 
 number_t crabLitFactoryImpl::getIntCst(const crab_lit_ref_t ref) const {
-  if (!ref || !ref->isInt())
-    CLAM_ERROR("Literal is not an integer");
-  auto lit = std::static_pointer_cast<const crabIntLit>(ref);
-  return lit->getInt();
+  if (!ref || !ref->isInt() || !ref->isConst())
+    CLAM_ERROR("Literal is not an integer constant");
+  return ref->getInt();
 }
 
-Optional<crabBoolLit> crabLitFactoryImpl::getBoolLit(const Value &v) {
+Optional<crabLit> crabLitFactoryImpl::getBoolLit(const Value &v) {
   if (isBool(v)) {
     if (const ConstantInt *c = dyn_cast<const ConstantInt>(&v)) {
       // -- constant boolean
       bool is_bignum;
       ikos::z_number n = getIntConstant(c, m_params, is_bignum);
       if (!is_bignum) {
-        return crabBoolLit(n > 0 ? true : false);
+        return crabLit::mkBool(n > 0 ? true : false);
       }
     } else if (!isa<ConstantExpr>(v)) {
       // -- boolean variable
       if (isa<UndefValue>(v)) {
         // Create a fresh variable: this treats an undef value as a
         // nondeterministic value.
-        return crabBoolLit(var_t(m_vfac.get(), BOOL_TYPE, 1));
+        return crabLit::mkBool(var_t(m_vfac.get(), BOOL_TYPE, 1));
       } else {
-        return crabBoolLit(var_t(m_vfac[&v], BOOL_TYPE, 1));
+        return crabLit::mkBool(var_t(m_vfac[&v], BOOL_TYPE, 1));
       }
     }
   }
   return None;
 }
 
-Optional<crabRefLit> crabLitFactoryImpl::getRefLit(const Value &v) {
+Optional<crabLit> crabLitFactoryImpl::getRefLit(const Value &v) {
   if (isa<ConstantPointerNull>(&v)) {
     // -- constant null
-    return crabRefLit();
+    return crabLit::mkNull();
   } else if (v.getType()->isPointerTy() && !isa<ConstantExpr>(v)) {
     // -- pointer variable
     if (isa<UndefValue>(v)) {
       // Create a fresh variable: this treats an undef value as a
       // nondeterministic value.
-      return crabRefLit(var_t(m_vfac.get(), REF_TYPE));
+      return crabLit::mkRef(var_t(m_vfac.get(), REF_TYPE));
     } else {
-      return crabRefLit(var_t(m_vfac[&v], REF_TYPE));
+      return crabLit::mkRef(var_t(m_vfac[&v], REF_TYPE));
     }
   }
   return None;
 }
 
-Optional<crabIntLit> crabLitFactoryImpl::getIntLit(const Value &v) {
+Optional<crabLit> crabLitFactoryImpl::getIntLit(const Value &v) {
   if (isInteger(v)) {
     if (const ConstantInt *c = dyn_cast<const ConstantInt>(&v)) {
       // -- constant integer
@@ -402,7 +370,7 @@ Optional<crabIntLit> crabLitFactoryImpl::getIntLit(const Value &v) {
       bool is_bignum;
       ikos::z_number n = getIntConstant(c, m_params, is_bignum);
       if (!is_bignum) {
-        return crabIntLit(n, bitwidth);
+        return crabLit::mkInt(n, bitwidth);
       }
     } else if (!isa<ConstantExpr>(v)) {
       // -- integer variable
@@ -410,9 +378,9 @@ Optional<crabIntLit> crabLitFactoryImpl::getIntLit(const Value &v) {
       if (isa<UndefValue>(v)) {
         // Create a fresh variable: this treats an undef value as a
         // nondeterministic value.
-        return crabIntLit(var_t(m_vfac.get(), INT_TYPE, bitwidth));
+        return crabLit::mkInt(var_t(m_vfac.get(), INT_TYPE, bitwidth));
       } else {
-        return crabIntLit(var_t(m_vfac[&v], INT_TYPE, bitwidth));
+        return crabLit::mkInt(var_t(m_vfac[&v], INT_TYPE, bitwidth));
       }
     }
   }
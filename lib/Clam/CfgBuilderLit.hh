@@ -10,11 +10,15 @@
 #include "clam/HeapAbstraction.hh"
 #include "clam/crab/crab_lang.hh"
 
-#include <unordered_map>
-
 namespace clam {
 
-// Convenient wrapper for a LLVM variable or constant
+// Convenient wrapper for a LLVM variable or constant.
+//
+// A literal is a tagged value: a Boolean literal is either a variable
+// or constants true and false, a reference literal is either a
+// variable or constant null, and a numerical literal is either a
+// variable or constant number. Literals are owned by crabLitFactory
+// and they are alive as long as their factory.
 class crabLit {
 public:
   enum lit_class_t {
@@ -23,178 +27,118 @@ public:
     CRAB_LITERAL_REF,
   };
 
-  crabLit(lit_class_t lit_class) : m_lit_class(lit_class) {}
-
-  virtual ~crabLit() {}
-
-  bool isBool() const { return m_lit_class == CRAB_LITERAL_BOOL; }
-
-  bool isInt() const { return m_lit_class == CRAB_LITERAL_INT; }
-
-  bool isRef() const { return m_lit_class == CRAB_LITERAL_REF; }
-
-  virtual bool isVar() const = 0;
-
-  virtual var_t getVar() const = 0;
-
-  virtual void write(crab::crab_os &out) const = 0;
-
 private:
-  lit_class_t m_lit_class;
-};
-
-inline crab::crab_os &operator<<(crab::crab_os &out, const crabLit &l) {
-  l.write(out);
-  return out;
-}
-
-/** A Boolean literal is either a variable or constants true and false. **/
-class crabBoolLit : public crabLit {
   friend class crabLitFactoryImpl;
 
-  bool m_cst; // only considered if !m_var.hasValue()
+  lit_class_t m_lit_class;
+  // if !m_var.hasValue() then the literal is a constant
   llvm::Optional<var_t> m_var;
+  bool m_cst;          // only for Boolean constants
+  number_t m_num;      // only for integer constants
+  unsigned m_bitwidth; // only for integers
 
-  crabBoolLit(bool cst) : crabLit(CRAB_LITERAL_BOOL), m_cst(cst) {}
-
-  crabBoolLit(var_t var) : crabLit(CRAB_LITERAL_BOOL), m_var(var) {}
-
-public:
-  bool isVar() const override { return (m_var.hasValue()); }
+  crabLit(lit_class_t lit_class, llvm::Optional<var_t> var, bool cst,
+          number_t num, unsigned bitwidth)
+      : m_lit_class(lit_class), m_var(var), m_cst(cst), m_num(num),
+        m_bitwidth(bitwidth) {}
 
-  var_t getVar() const override {
-    assert(isVar());
-    return m_var.getValue();
+  static crabLit mkBool(bool cst) {
+    return crabLit(CRAB_LITERAL_BOOL, llvm::None, cst, number_t(0), 1);
   }
-
-  bool isConst() const { return !isVar(); }
-
-  bool isTrue() const {
-    if (!isConst())
-      return false;
-    return m_cst;
+  static crabLit mkBool(var_t v) {
+    return crabLit(CRAB_LITERAL_BOOL, v, false, number_t(0), 1);
   }
-
-  bool isFalse() const {
-    if (!isConst())
-      return false;
-    return !m_cst;
+  static crabLit mkNull() {
+    return crabLit(CRAB_LITERAL_REF, llvm::None, false, number_t(0), 0);
   }
-
-  var_or_cst_t getTypedConst() const {
-    assert(isConst());
-
-    if (isTrue()) {
-      return var_or_cst_t::make_bool_true();
-    } else {
-      return var_or_cst_t::make_bool_false();
-    }
+  static crabLit mkRef(var_t v) {
+    return crabLit(CRAB_LITERAL_REF, v, false, number_t(0), 0);
   }
-
-  void write(crab::crab_os &out) const override {
-    if (isVar()) {
-      out << getVar();
-    } else if (isTrue()) {
-      out << "true";
-    } else {
-      out << "false";
-    }
+  // If z_number != number_t we assume that number_t has a
+  // constructor for z_number.
+  static crabLit mkInt(ikos::z_number n, unsigned bitwidth) {
+    return crabLit(CRAB_LITERAL_INT, llvm::None, false, number_t(n), bitwidth);
+  }
+  static crabLit mkInt(var_t v) {
+    return crabLit(CRAB_LITERAL_INT, v, false, number_t(0),
+                   v.get_type().get_integer_bitwidth());
   }
-};
-
-/** A reference literal is either a variable or constant null.**/
-class crabRefLit : public crabLit {
-  friend class crabLitFactoryImpl;
-
-  // if !m_lit.hasValue() then the literal represents null
-  llvm::Optional<var_t> m_lit;
-
-  crabRefLit() : crabLit(CRAB_LITERAL_REF) {} // null
-  crabRefLit(var_t v) : crabLit(CRAB_LITERAL_REF), m_lit(v) {}
 
 public:
-  bool isVar() const override { return m_lit.hasValue(); }
+  bool isBool() const { return m_lit_class == CRAB_LITERAL_BOOL; }
 
-  var_t getVar() const override {
-    assert(isVar());
-    return m_lit.getValue();
-  }
+  bool isInt() const { return m_lit_class == CRAB_LITERAL_INT; }
 
-  bool isNull() const { return !isVar(); }
+  bool isRef() const { return m_lit_class == CRAB_LITERAL_REF; }
 
-  var_or_cst_t getTypedConst() const {
-    assert(isNull());
-    return var_or_cst_t::make_reference_null();
-  }
+  bool isVar() const { return m_var.hasValue(); }
 
-  void write(crab::crab_os &out) const override {
-    if (isVar()) {
-      out << getVar();
-    } else {
-      out << "NULL";
-    }
+  var_t getVar() const {
+    assert(isVar());
+    return m_var.getValue();
   }
-};
-
-/** A numerical literal is either a variable or constant number.**/
-class crabIntLit : public crabLit {
-  friend class crabLitFactoryImpl;
 
-  number_t m_num; // only considered if !m_var.hasValue()
-  llvm::Optional<var_t> m_var;
-  unsigned m_bitwidth;
+  bool isConst() const { return !isVar(); }
 
-  // If z_number != number_t we assume that number_t has a
-  // constructor for z_number.
-  explicit crabIntLit(ikos::z_number n, unsigned bitwidth)
-      : crabLit(CRAB_LITERAL_INT), m_num(n), m_bitwidth(bitwidth) {}
+  bool isTrue() const { return isBool() && isConst() && m_cst; }
 
-  explicit crabIntLit(var_t v)
-      : crabLit(CRAB_LITERAL_INT), m_var(v),
-        m_bitwidth(v.get_type().get_integer_bitwidth()) {}
+  bool isFalse() const { return isBool() && isConst() && !m_cst; }
 
-public:
-  bool isVar() const override { return m_var.hasValue(); }
+  bool isNull() const { return isRef() && isConst(); }
 
-  var_t getVar() const override {
-    assert(isVar());
-    return m_var.getValue();
-  }
-
-  bool isInt() const { return !isVar(); }
-
-  var_or_cst_t getTypedConst() const {
+  unsigned getBitwidth() const {
     assert(isInt());
-    return var_or_cst_t(getInt(),
-                        crab::variable_type(crab::INT_TYPE, getBitwidth()));
+    return m_bitwidth;
   }
 
-  unsigned getBitwidth() const { return m_bitwidth; }
-
   number_t getInt() const {
-    assert(isInt());
+    assert(isInt() && isConst());
     return m_num;
   }
 
   lin_exp_t getExp() const {
-    if (isInt())
+    assert(isInt());
+    if (isConst()) {
       return lin_exp_t(getInt());
-    else {
-      assert(isVar());
+    } else {
       return lin_exp_t(getVar());
     }
   }
 
-  void write(crab::crab_os &out) const override {
+  var_or_cst_t getTypedConst() const {
+    assert(isConst());
+    if (isBool()) {
+      return (m_cst ? var_or_cst_t::make_bool_true()
+                    : var_or_cst_t::make_bool_false());
+    } else if (isInt()) {
+      return var_or_cst_t(getInt(),
+                          crab::variable_type(crab::INT_TYPE, getBitwidth()));
+    } else {
+      return var_or_cst_t::make_reference_null();
+    }
+  }
+
+  void write(crab::crab_os &out) const {
     if (isVar()) {
       out << getVar();
-    } else {
+    } else if (isBool()) {
+      out << (m_cst ? "true" : "false");
+    } else if (isInt()) {
       out << getInt();
+    } else {
+      out << "NULL";
     }
   }
 };
 
-typedef std::shared_ptr<crabLit> crab_lit_ref_t;
+inline crab::crab_os &operator<<(crab::crab_os &out, const crabLit &l) {
+  l.write(out);
+  return out;
+}
+
+// Literals are allocated in the arena of their factory so a reference
+// is a plain pointer.
+typedef const crabLit *crab_lit_ref_t;
 
 class crabLitFactoryImpl;
 
@@ -214,7 +158,8 @@ public:
 
   const CrabBuilderParams &getCfgBuilderParams() const;
 
-  /** convert a Value to a crabLit **/
+  /** convert a Value to a crabLit. The literal is owned by the factory.
+   ** Return nullptr if v cannot be translated. **/
   crab_lit_ref_t getLit(const llvm::Value &v);
 
   /** make fresh typed variables.
@@ -234,7 +179,7 @@ public:
   var_t mkRegionVar(Region rgn);
   var_t mkScalarVar(Region rgn);
 
-  /** direct accessors to crabLit subclasses **/
+  /** checked accessors to crabLit **/
   bool isBoolTrue(const crab_lit_ref_t ref) const;
   bool isBoolFalse(const crab_lit_ref_t ref) const;
   bool isRefNull(const crab_lit_ref_t ref) const;
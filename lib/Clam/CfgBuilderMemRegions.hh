@@ -9,6 +9,7 @@
 
 #include "CfgBuilderUtils.hh"
 
+#include <map>
 #include <set>
 
 /**
@@ -65,52 +66,53 @@ inline const llvm::Value *getSingletonValue(Region r,
   return nullptr;
 }
 
-// v is either a llvm::Function or llvm::CallInst.
-template <typename V>
-inline RegionVec getInputRegions(HeapAbstraction &mem,
-                                 const CrabBuilderParams &params, V &v) {
-  auto regions = mem.getOnlyReadRegions(v);
-  if (params.trackMemory()) {
-    return regions;
-  } else {
-    RegionVec scalar_regions;
-    std::copy_if(regions.begin(), regions.end(),
-                 std::back_inserter(scalar_regions),
-                 [&params](Region r) { return isTrackedRegion(r, params); });
-    return scalar_regions;
+// The memory regions of functions and callsites that are tracked
+// with the precision level of the translation. The regions are
+// filtered only once so they can be returned by reference.
+class TrackedRegions {
+public:
+  TrackedRegions(HeapAbstraction &mem, const CrabBuilderParams &params)
+      : m_mem(mem), m_params(params) {}
+
+  // v is either a llvm::Function or llvm::CallInst.
+  template <typename V> const RegionVec &getInputRegions(V &v) {
+    return filter(&v, INPUT, m_mem.getOnlyReadRegions(v));
   }
-}
 
-// v is either a llvm::Function or llvm::CallInst.
-template <typename V>
-inline RegionVec getInputOutputRegions(HeapAbstraction &mem,
-                                       const CrabBuilderParams &params, V &v) {
-  auto regions = mem.getModifiedRegions(v);
-  if (params.trackMemory()) {
-    return regions;
-  } else {
-    RegionVec scalar_regions;
-    std::copy_if(regions.begin(), regions.end(),
-                 std::back_inserter(scalar_regions),
-                 [&params](Region r) { return isTrackedRegion(r, params); });
-    return scalar_regions;
+  // v is either a llvm::Function or llvm::CallInst.
+  template <typename V> const RegionVec &getInputOutputRegions(V &v) {
+    return filter(&v, INPUT_OUTPUT, m_mem.getModifiedRegions(v));
   }
-}
 
-// v is either a llvm::Function or llvm::CallInst.
-template <typename V>
-inline RegionVec getOutputRegions(HeapAbstraction &mem,
-                                  const CrabBuilderParams &params, V &v) {
-  auto regions = mem.getNewRegions(v);
-  if (params.trackMemory()) {
-    return regions;
-  } else {
-    RegionVec scalar_regions;
+  // v is either a llvm::Function or llvm::CallInst.
+  template <typename V> const RegionVec &getOutputRegions(V &v) {
+    return filter(&v, OUTPUT, m_mem.getNewRegions(v));
+  }
+
+private:
+  enum Kind { INPUT, INPUT_OUTPUT, OUTPUT };
+
+  const RegionVec &filter(const llvm::Value *v, Kind kind,
+                          const RegionVec &regions) {
+    if (m_params.trackMemory()) {
+      return regions;
+    }
+    auto it = m_cache.find({v, kind});
+    if (it != m_cache.end()) {
+      return it->second;
+    }
+    RegionVec &scalar_regions = m_cache[{v, kind}];
     std::copy_if(regions.begin(), regions.end(),
                  std::back_inserter(scalar_regions),
-                 [&params](Region r) { return isTrackedRegion(r, params); });
+                 [this](Region r) { return isTrackedRegion(r, m_params); });
     return scalar_regions;
   }
-}
+
+  HeapAbstraction &m_mem;
+  const CrabBuilderParams &m_params;
+  // std::map so that returned references are not invalidated by
+  // later insertions
+  std::map<std::pair<const llvm::Value *, Kind>, RegionVec> m_cache;
+};
 
 } // end namespace clam
@@ -1,26 +1,34 @@
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/Triple.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/UnifyFunctionExitNodes.h"
 
 #include "clam/config.h"
 #include "clam/CfgBuilder.hh"
 #include "clam/Clam.hh"
+#include "clam/ClamAliasAnalysis.hh"
 #include "clam/ClamAnalysisParams.hh"
+#include "clam/ClamInvariants.hh"
+#include "clam/ClamRangeTable.hh"
 #include "clam/CrabDomainParser.hh"
 #include "clam/DummyHeapAbstraction.hh"
 #include "clam/RegisterAnalysis.hh"
@@ -52,6 +60,7 @@
 #include "crab/support/stats.hpp"
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <unordered_map>
 
@@ -65,9 +74,16 @@ namespace clam {
 /** =========== Begin typedefs ==========**/
 using checks_db_t = typename IntraClam::checks_db_t;
 using abs_dom_map_t = typename IntraClam::abs_dom_map_t;
+using stmt_abs_dom_map_t = typename ClamGlobalAnalysis::stmt_abs_dom_map_t;
 using lin_csts_map_t = typename IntraClam::lin_csts_map_t;
 using edges_set =
       std::set<std::pair<const llvm::BasicBlock *, const llvm::BasicBlock *>>;
+// An LLVM edge can be represented by several crab blocks (e.g., one
+// per range of switch case values) so it is feasible if any of them
+// is not bottom.
+using edges_feasibility_map =
+      std::map<std::pair<const llvm::BasicBlock *, const llvm::BasicBlock *>,
+               bool>;
 // -- live symbols
 using liveness_t = crab::analyzer::live_and_dead_analysis<cfg_ref_t>;
 using liveness_map_t = std::unordered_map<cfg_ref_t, const liveness_t *>;
@@ -104,21 +120,43 @@ public:
   abs_dom_map_t &premap;
   // invariants that hold at the exit of a block
   abs_dom_map_t &postmap;
+  // invariants that hold after some instructions
+  stmt_abs_dom_map_t &stmt_postmap;
   // infeasible edges 
   edges_set &infeasible_edges;
   // database with all the checks
   checks_db_t &checksdb;
 
   AnalysisResults(abs_dom_map_t &pre, abs_dom_map_t &post,
+                  stmt_abs_dom_map_t &stmt_post,
                   edges_set &false_edges, checks_db_t &db)
-      : premap(pre), postmap(post), infeasible_edges(false_edges),
-        checksdb(db) {}
+      : premap(pre), postmap(post), stmt_postmap(stmt_post),
+        infeasible_edges(false_edges), checksdb(db) {}
 };
 
 static bool isTrackable(const Function &fun) {
   return !fun.isDeclaration() && !fun.empty() && !fun.isVarArg();
 }
 
+/** return invariants but filtering out shadow_varnames **/
+static clam_abstract_domain
+removeShadows(const clam_abstract_domain &invariants,
+              const std::vector<varname_t> &shadow_varnames) {
+  if (shadow_varnames.empty()) {
+    return invariants;
+  } else {
+    std::vector<var_t> shadow_vars;
+    shadow_vars.reserve(shadow_varnames.size());
+    for (unsigned i = 0; i < shadow_vars.size(); ++i) {
+      // we need to create a typed variable
+      shadow_vars.push_back(var_t(shadow_varnames[i], crab::UNK_TYPE, 0));
+    }
+    clam_abstract_domain copy_invariants(invariants);
+    copy_invariants.forget(shadow_vars);
+    return copy_invariants;
+  }
+}
+
 /** return invariant for block in table but filtering out shadow_varnames **/
 static llvm::Optional<clam_abstract_domain>
 lookup(const abs_dom_map_t &table, const llvm::BasicBlock &block,
@@ -128,20 +166,81 @@ lookup(const abs_dom_map_t &table, const llvm::BasicBlock &block,
   if (it == table.end()) {
     return llvm::None;
   }
+  return removeShadows(it->second, shadow_varnames);
+}
 
-  if (shadow_varnames.empty()) {
-    return it->second;
-  } else {
-    std::vector<var_t> shadow_vars;
-    shadow_vars.reserve(shadow_varnames.size());
-    for (unsigned i = 0; i < shadow_vars.size(); ++i) {
-      // we need to create a typed variable
-      shadow_vars.push_back(var_t(shadow_varnames[i], crab::UNK_TYPE, 0));
+/** return invariant after I in table but filtering out shadow_varnames **/
+static llvm::Optional<clam_abstract_domain>
+lookupStmt(const stmt_abs_dom_map_t &table, const llvm::Instruction &I,
+           // remove shadow variables
+           const std::vector<varname_t> &shadow_varnames) {
+  auto it = table.find(&I);
+  if (it == table.end()) {
+    return llvm::None;
+  }
+  return removeShadows(it->second, shadow_varnames);
+}
+
+/** return true if the invariants after I must be stored **/
+static bool isStmtInvariantStored(const AnalysisParams &params,
+                                  const Instruction &I) {
+  return (isa<LoadInst>(I) &&
+          params.storeStmtInvariants(StmtInvariantsKind::LOAD)) ||
+         (isa<GetElementPtrInst>(I) &&
+          params.storeStmtInvariants(StmtInvariantsKind::GEP)) ||
+         (isa<CallInst>(I) &&
+          params.storeStmtInvariants(StmtInvariantsKind::CALL)) ||
+         (I.getMetadata("clam-store-invariant") &&
+          params.storeStmtInvariants(StmtInvariantsKind::MARKED));
+}
+
+/**
+ * Store in table the invariants that hold after the first statement
+ * of bb that defines each instruction selected by params. pre is the
+ * fixpoint invariant at the entry of bb so the block is propagated
+ * only once for all clients.
+ **/
+static void storeStmtInvariants(const AnalysisParams &params,
+                                basic_block_t &bb, clam_abstract_domain pre,
+                                stmt_abs_dom_map_t &table) {
+  if (params.store_stmt_invariants == 0) {
+    return;
+  }
+  forEachStmtPost(bb, pre, [&](const statement_t &s, clam_abstract_domain &inv) {
+    auto &live = s.get_live();
+    for (auto it = live.defs_begin(), et = live.defs_end(); it != et; ++it) {
+      if (!(*it).name().get()) {
+        continue;
+      }
+      auto I = dyn_cast<const Instruction>(*((*it).name().get()));
+      if (I && isStmtInvariantStored(params, *I) && !table.count(I)) {
+        table.insert({I, inv});
+      }
     }
-    clam_abstract_domain copy_invariants(it->second);
-    copy_invariants.forget(shadow_vars);
-    return copy_invariants;
+    return true;
+  });
+}
+
+/**
+ * Return the invariant at the entry of the LLVM block B given pre,
+ * the invariant at the entry of its crab block bb. If the incoming
+ * edge of B is folded into bb then the statements that model the
+ * edge are propagated first.
+ **/
+static clam_abstract_domain getEntryInvariant(const CfgBuilder &builder,
+                                              const BasicBlock &B,
+                                              basic_block_t &bb,
+                                              clam_abstract_domain pre) {
+  unsigned n = builder.getNumFoldedEdgeStatements(&B);
+  if (n == 0) {
+    return pre;
   }
+  clam_abstract_domain res(pre);
+  forEachStmtPost(bb, pre, [&](const statement_t &, clam_abstract_domain &inv) {
+    res = inv;
+    return --n > 0;
+  });
+  return res;
 }
 
 /** update table with pre or post invariants **/
@@ -268,6 +367,7 @@ public:
   void clear() {
     m_pre_map.clear();
     m_post_map.clear();
+    m_stmt_post_map.clear();
     m_checks_db.clear();
     m_infeasible_edges.clear();
   }
@@ -280,6 +380,7 @@ private:
   // To store analysis results
   abs_dom_map_t m_pre_map;
   abs_dom_map_t m_post_map;
+  stmt_abs_dom_map_t m_stmt_post_map;
   edges_set m_infeasible_edges;
   checks_db_t m_checks_db;
   
@@ -338,6 +439,7 @@ private:
     // -- store invariants
     if (params.store_invariants || params.print_invars) {
       CRAB_VERBOSE_IF(1, crab::get_msg_stream() << "Storing analysis results.\n");
+      edges_feasibility_map feasible_edges;
       for (basic_block_label_t bl :
            llvm::make_range(m_cfg_builder->getCfg().label_begin(),
                             m_cfg_builder->getCfg().label_end())) {
@@ -347,15 +449,23 @@ private:
           //   to the branch condition in the predecessor of the
           //   LLVM edge. We want the invariant *after* the
           //   evaluation of the assume.
-          if (analyzer.get_post(bl).is_bottom()) {
-            results.infeasible_edges.insert(
-                {bl.get_edge().first, bl.get_edge().second});
-          }
+          bool &feasible = feasible_edges[bl.get_edge()];
+          feasible |= !analyzer.get_post(bl).is_bottom();
         } else if (const BasicBlock *B = bl.get_basic_block()) {
+          basic_block_t &bb = m_cfg_builder->getCfg().get_node(bl);
+          clam_abstract_domain pre =
+              getEntryInvariant(*m_cfg_builder, *B, bb, analyzer.get_pre(bl));
+          if (m_cfg_builder->getNumFoldedEdgeStatements(B) > 0 &&
+              pre.is_bottom()) {
+            // the incoming edge of B has no crab block
+            results.infeasible_edges.insert({B->getSinglePredecessor(), B});
+          }
           // --- invariants that hold at the entry of the blocks
-          update(results.premap, *B, analyzer.get_pre(bl));
+          update(results.premap, *B, pre);
           // --- invariants that hold at the exit of the blocks
           update(results.postmap, *B, analyzer.get_post(bl));
+          // --- invariants that hold after some instructions
+          storeStmtInvariants(params, bb, pre, results.stmt_postmap);
         } else {
           // this should be unreachable
           assert(
@@ -363,6 +473,11 @@ private:
               "A Crab block should correspond to either an LLVM edge or block");
         }
       }
+      for (auto &kv : feasible_edges) {
+        if (!kv.second) {
+          results.infeasible_edges.insert(kv.first);
+        }
+      }
       CRAB_VERBOSE_IF(1, crab::get_msg_stream() << "Finished storing analysis results.\n");
     }
 
@@ -452,7 +567,7 @@ CrabBuilderManager &IntraClam::getCfgBuilderMan() {
 void IntraClam::analyze(AnalysisParams &params,
                         const abs_dom_map_t &assumptions) {
   AnalysisResults results =
-    {m_impl->m_pre_map, m_impl->m_post_map,
+    {m_impl->m_pre_map, m_impl->m_post_map, m_impl->m_stmt_post_map,
      m_impl->m_infeasible_edges,
      m_impl->m_checks_db};
   lin_csts_map_t lin_csts_assumptions;
@@ -463,7 +578,7 @@ void IntraClam::analyze(AnalysisParams &params,
 void IntraClam::analyze(AnalysisParams &params, const llvm::BasicBlock *entry,
                         const abs_dom_map_t &assumptions) {
   AnalysisResults results =
-    {m_impl->m_pre_map, m_impl->m_post_map,
+    {m_impl->m_pre_map, m_impl->m_post_map, m_impl->m_stmt_post_map,
      m_impl->m_infeasible_edges,
      m_impl->m_checks_db};
   lin_csts_map_t lin_csts_assumptions;
@@ -473,7 +588,7 @@ void IntraClam::analyze(AnalysisParams &params, const llvm::BasicBlock *entry,
 void IntraClam::analyze(AnalysisParams &params,
                         const lin_csts_map_t &assumptions) {
   AnalysisResults results =
-    {m_impl->m_pre_map, m_impl->m_post_map,
+    {m_impl->m_pre_map, m_impl->m_post_map, m_impl->m_stmt_post_map,
      m_impl->m_infeasible_edges,
      m_impl->m_checks_db};
   abs_dom_map_t abs_dom_assumptions;
@@ -484,7 +599,7 @@ void IntraClam::analyze(AnalysisParams &params,
 void IntraClam::analyze(AnalysisParams &params, const llvm::BasicBlock *entry,
                         const lin_csts_map_t &assumptions) {
   AnalysisResults results =
-    {m_impl->m_pre_map, m_impl->m_post_map,
+    {m_impl->m_pre_map, m_impl->m_post_map, m_impl->m_stmt_post_map,
      m_impl->m_infeasible_edges,
      m_impl->m_checks_db};
   abs_dom_map_t abs_dom_assumptions;
@@ -529,6 +644,16 @@ IntraClam::getPost(const llvm::BasicBlock *block, bool keep_shadows) const {
   return lookup(m_impl->m_post_map, *block, shadows);
 }
 
+llvm::Optional<clam_abstract_domain>
+IntraClam::getPostStmt(const llvm::Instruction *I, bool keep_shadows) const {
+  std::vector<varname_t> shadows;
+  auto &vfac = m_impl->m_cfg_builder_man.getVarFactory();
+  if (!keep_shadows)
+    shadows = std::vector<varname_t>(vfac.get_shadow_vars().begin(),
+                                     vfac.get_shadow_vars().end());
+  return lookupStmt(m_impl->m_stmt_post_map, *I, shadows);
+}
+
 bool IntraClam::hasFeasibleEdge(const llvm::BasicBlock *b1,
                                 const llvm::BasicBlock *b2) const {
   return !(m_impl->m_infeasible_edges.count({b1, b2}) > 0);
@@ -545,7 +670,8 @@ const checks_db_t &IntraClam::getChecksDB() const {
 class IntraGlobalClamImpl {
 public:  
   IntraGlobalClamImpl(const llvm::Module &module, CrabBuilderManager &man)
-    : m_module(module), m_builder_man(man), m_query_cache(m_builder_man) {}
+    : m_module(module), m_builder_man(man),
+      m_query_cache(m_builder_man, getPostStmtFn()) {}
 
   ~IntraGlobalClamImpl() = default;
 
@@ -556,12 +682,14 @@ public:
   void clear() {
     m_pre_map.clear();
     m_post_map.clear();
+    m_stmt_post_map.clear();
     m_checks_db.clear();
     m_infeasible_edges.clear();  
   }
     
 
-  void analyze(AnalysisParams &params, const abs_dom_map_t &abs_dom_assumptions) {
+  void analyze(AnalysisParams &params, const abs_dom_map_t &abs_dom_assumptions,
+	       const std::function<void(const Function &)> &analyzedFn) {
     if (params.run_inter) {
       CLAM_WARNING("Analysis is intra-procedural but user wants inter-procedural. "
 		   << "Running intra-procedural analysis.");
@@ -579,13 +707,21 @@ public:
 			<< "###Function " << fun_counter << "/"
 			<< num_analyzed_funcs << "###\n";);
 	++fun_counter;
-	IntraClamImpl intra_crab(F, m_builder_man);
-	AnalysisResults results =
-	  {m_pre_map, m_post_map,
-	   m_infeasible_edges, m_checks_db};
-	lin_csts_map_t lin_csts_assumptions/*unused*/;
-	intra_crab.analyze(params, &F.getEntryBlock(), abs_dom_assumptions,
-			   lin_csts_assumptions, results);
+	{
+	  IntraClamImpl intra_crab(F, m_builder_man);
+	  AnalysisResults results =
+	    {m_pre_map, m_post_map, m_stmt_post_map,
+	     m_infeasible_edges, m_checks_db};
+	  lin_csts_map_t lin_csts_assumptions/*unused*/;
+	  intra_crab.analyze(params, &F.getEntryBlock(), abs_dom_assumptions,
+			     lin_csts_assumptions, results);
+	}
+	if (analyzedFn) {
+	  analyzedFn(F);
+	}
+	if (params.stream_functions) {
+	  release(F);
+	}
       }
     }
     if (params.stats) {
@@ -593,6 +729,23 @@ public:
     }
   }
 
+  // Free the invariants and the crab CFG of F. The checks and the
+  // infeasible edges are kept because they are small. The crab
+  // variables of F are not freed: the variable factory is shared by
+  // all the functions and it does not support removing variables.
+  void release(const Function &F) {
+    for (auto &B : F) {
+      m_pre_map.erase(&B);
+      m_post_map.erase(&B);
+      if (!m_stmt_post_map.empty()) {
+	for (auto &I : B) {
+	  m_stmt_post_map.erase(&I);
+	}
+      }
+    }
+    m_builder_man.releaseCfgBuilder(F);
+  }
+
   Optional<clam_abstract_domain> getPre(const BasicBlock *bb,
 					bool keep_shadows) const {
     std::vector<varname_t> shadows;
@@ -613,6 +766,16 @@ public:
     return lookup(m_post_map, *bb, shadows);
   }
 
+  Optional<clam_abstract_domain> getPostStmt(const Instruction *I,
+					     bool keep_shadows) const {
+    std::vector<varname_t> shadows;
+    if (!keep_shadows)
+      shadows = std::vector<varname_t>(
+        m_builder_man.getVarFactory().get_shadow_vars().begin(),
+        m_builder_man.getVarFactory().get_shadow_vars().end());
+    return lookupStmt(m_stmt_post_map, *I, shadows);
+  }
+
   const checks_db_t &getChecksDB() const {
     return m_checks_db;
   }
@@ -622,25 +785,34 @@ public:
     return !(m_infeasible_edges.count({b1, b2}) > 0);    
   }
 
+  // Used by the query cache to get invariants on demand
+  ClamQueryCache::getPreFn getPreFn() const {
+    return [this](const BasicBlock *b) { return getPre(b, false); };
+  }
+
+  ClamQueryCache::getPostStmtFn getPostStmtFn() const {
+    return [this](const Instruction *I) { return getPostStmt(I, false); };
+  }
+
   AliasResult alias(const MemoryLocation &l1, const MemoryLocation &l2,
 		    AAQueryInfo &AAQI) {
-    return m_query_cache.alias(l1, l2, AAQI);
+    return m_query_cache.alias(l1, l2, AAQI, getPreFn());
   }
   
   ClamQueryAPI::Range range(const Instruction &I) {
-    return m_query_cache.range(I, getPre(I.getParent(), false));
+    return m_query_cache.range(I, getPreFn());
   }
   
   ClamQueryAPI::Range range(const BasicBlock &B, const Value &V) {
-    return m_query_cache.range(B, V, getPre(&B, false));
+    return m_query_cache.range(B, V, getPreFn());
   }
 
   Optional<ClamQueryAPI::TagVector> tags(const Instruction &I) {
-    return m_query_cache.tags(I, getPre(I.getParent(), false));
+    return m_query_cache.tags(I, getPreFn());
   }
   
   Optional<ClamQueryAPI::TagVector> tags(const BasicBlock &B, const Value &V) {
-    return m_query_cache.tags(B, V, getPre(&B, false));
+    return m_query_cache.tags(B, V, getPreFn());
   }
   
 private:
@@ -649,6 +821,7 @@ private:
   // To store analysis results
   abs_dom_map_t m_pre_map;
   abs_dom_map_t m_post_map;
+  stmt_abs_dom_map_t m_stmt_post_map;
   edges_set m_infeasible_edges;
   checks_db_t m_checks_db;
   // To answer analysis queries
@@ -665,7 +838,7 @@ class InterGlobalClamImpl {
 public:
   InterGlobalClamImpl(const Module &M, CrabBuilderManager &man)
     : m_cg(nullptr), m_crab_builder_man(man), m_M(M),
-      m_query_cache(m_crab_builder_man) {
+      m_query_cache(m_crab_builder_man, getPostStmtFn()) {
     std::vector<cfg_ref_t> cfg_ref_vector;
     for (auto const &F : m_M) {
       if (isTrackable(F)) {
@@ -682,8 +855,12 @@ public:
 
   void analyze(AnalysisParams &params,
 	       const abs_dom_map_t &assumptions) {
+    if (params.stream_functions) {
+      CLAM_WARNING("Streaming functions is only available for the "
+		   << "intra-procedural analysis. Ignored.");
+    }
     AnalysisResults results =
-      {m_pre_map, m_post_map,
+      {m_pre_map, m_post_map, m_stmt_post_map,
        m_infeasible_edges,
        m_checks_db};
     lin_csts_map_t lin_csts_assumptions;
@@ -696,7 +873,7 @@ public:
   void analyze(AnalysisParams &params,
 	       const lin_csts_map_t &assumptions) {
     AnalysisResults results =
-      {m_pre_map, m_post_map,
+      {m_pre_map, m_post_map, m_stmt_post_map,
        m_infeasible_edges,
        m_checks_db};
     abs_dom_map_t abs_dom_assumptions;
@@ -725,31 +902,51 @@ public:
         m_crab_builder_man.getVarFactory().get_shadow_vars().end());
     return lookup(m_post_map, *block, shadows);
   }
+
+  Optional<clam_abstract_domain>
+  getPostStmt(const Instruction *I, bool keep_shadows) const {
+    std::vector<varname_t> shadows;
+    if (!keep_shadows)
+      shadows = std::vector<varname_t>(
+        m_crab_builder_man.getVarFactory().get_shadow_vars().begin(),
+        m_crab_builder_man.getVarFactory().get_shadow_vars().end());
+    return lookupStmt(m_stmt_post_map, *I, shadows);
+  }
   
+  // Used by the query cache to get invariants on demand
+  ClamQueryCache::getPreFn getPreFn() const {
+    return [this](const BasicBlock *b) { return getPre(b, false); };
+  }
+
+  ClamQueryCache::getPostStmtFn getPostStmtFn() const {
+    return [this](const Instruction *I) { return getPostStmt(I, false); };
+  }
+
   AliasResult alias(const MemoryLocation &l1, const MemoryLocation &l2,
 		    AAQueryInfo &AAQI) {
-    return m_query_cache.alias(l1, l2, AAQI);    
+    return m_query_cache.alias(l1, l2, AAQI, getPreFn());
   }
   
   ClamQueryAPI::Range range(const Instruction &I) {
-    return m_query_cache.range(I, getPre(I.getParent(), false));    
+    return m_query_cache.range(I, getPreFn());
   }
   
   ClamQueryAPI::Range range(const BasicBlock &B, const Value &V) {
-    return m_query_cache.range(B, V, getPre(&B, false));    
+    return m_query_cache.range(B, V, getPreFn());
   }
 
   Optional<ClamQueryAPI::TagVector> tags(const Instruction &I) {
-    return m_query_cache.tags(I, getPre(I.getParent(), false));
+    return m_query_cache.tags(I, getPreFn());
   }
   
   Optional<ClamQueryAPI::TagVector> tags(const BasicBlock &B, const Value &V) {
-    return m_query_cache.tags(B, V, getPre(&B, false));
+    return m_query_cache.tags(B, V, getPreFn());
   }
   
   void clear() {
     m_pre_map.clear();
     m_post_map.clear();
+    m_stmt_post_map.clear();
     m_checks_db.clear();
     m_infeasible_edges.clear();  
   }
@@ -766,6 +963,7 @@ private:
   // To store analysis results
   abs_dom_map_t m_pre_map;
   abs_dom_map_t m_post_map;
+  stmt_abs_dom_map_t m_stmt_post_map;
   edges_set m_infeasible_edges;
   checks_db_t m_checks_db;
   // To answer analysis queries
@@ -889,6 +1087,7 @@ private:
 	CRAB_VERBOSE_IF(1, crab::get_msg_stream()
 			<< "Storing analysis results for "
 			<< F->getName().str() << ".\n");
+	edges_feasibility_map feasible_edges;
 	for (basic_block_label_t bl :
                llvm::make_range(cfg.label_begin(), cfg.label_end())) {
 	  if (bl.is_edge()) {
@@ -897,23 +1096,35 @@ private:
 	    //   to the branch condition in the predecessor of the
 	    //   LLVM edge. We want the invariant *after* the
 	    //   evaluation of the assume.
-	    if (analyzer.get_post(cfg, bl).is_bottom()) {
-	      results.infeasible_edges.insert(
-					      {bl.get_edge().first, bl.get_edge().second});
-	    }
+	    bool &feasible = feasible_edges[bl.get_edge()];
+	    feasible |= !analyzer.get_post(cfg, bl).is_bottom();
 	  } else if (const BasicBlock *B = bl.get_basic_block()) {
+	    auto builder = m_crab_builder_man.getCfgBuilder(*F);
+	    basic_block_t &bb = cfg.get_node(bl);
+	    auto pre = getEntryInvariant(
+	        *builder, *B, bb, analyzer.get_pre(cfg, getCrabBasicBlock(B)));
+	    if (builder->getNumFoldedEdgeStatements(B) > 0 && pre.is_bottom()) {
+	      // the incoming edge of B has no crab block
+	      results.infeasible_edges.insert({B->getSinglePredecessor(), B});
+	    }
 	    // --- invariants that hold at the entry of the blocks
-	    auto pre = analyzer.get_pre(cfg, getCrabBasicBlock(B));
 	    update(results.premap, *B, pre);
 	    // --- invariants that hold at the exit of the blocks
 	    auto post = analyzer.get_post(cfg, getCrabBasicBlock(B));
 	    update(results.postmap, *B, post);
+	    // --- invariants that hold after some instructions
+	    storeStmtInvariants(params, bb, pre, results.stmt_postmap);
 	  } else {
 	    // this should be unreachable
 	    assert(false && "A Crab block should correspond to either an "
 		   "LLVM edge or block");
 	  }
 	}
+	for (auto &kv : feasible_edges) {
+	  if (!kv.second) {
+	    results.infeasible_edges.insert(kv.first);
+	  }
+	}
 	CRAB_VERBOSE_IF(1, crab::get_msg_stream()
 			<< "Finished storing analysis results for "
 			<< F->getName().str() << ".\n");
@@ -967,7 +1178,15 @@ CrabBuilderManager &IntraGlobalClam::getCfgBuilderMan() {
 
 void IntraGlobalClam::analyze(AnalysisParams &params,
 			      const abs_dom_map_t &abs_dom_assumptions) {
-  m_impl->analyze(params, abs_dom_assumptions);
+  std::function<void(const Function &)> analyzedFn;
+  if (m_analyzed_fn) {
+    analyzedFn = [this](const Function &F) { m_analyzed_fn(F, *this); };
+  }
+  m_impl->analyze(params, abs_dom_assumptions, analyzedFn);
+}
+
+void IntraGlobalClam::setAnalyzedFunctionCallback(analyzed_function_fn_t fn) {
+  m_analyzed_fn = fn;
 }
 
 Optional<clam_abstract_domain>
@@ -980,6 +1199,11 @@ IntraGlobalClam::getPost(const BasicBlock *block, bool keep_shadows) const {
   return m_impl->getPost(block, keep_shadows);  
 }
 
+Optional<clam_abstract_domain>
+IntraGlobalClam::getPostStmt(const Instruction *I, bool keep_shadows) const {
+  return m_impl->getPostStmt(I, keep_shadows);
+}
+
 const checks_db_t &IntraGlobalClam::getChecksDB() const {
   return m_impl->getChecksDB();
 }
@@ -1048,6 +1272,11 @@ InterGlobalClam::getPost(const BasicBlock *bb, bool keep_shadows) const {
   return m_impl->getPost(bb, keep_shadows);
 }
 
+Optional<clam_abstract_domain>
+InterGlobalClam::getPostStmt(const Instruction *I, bool keep_shadows) const {
+  return m_impl->getPostStmt(I, keep_shadows);
+}
+
 const checks_db_t &InterGlobalClam::getChecksDB() const {
   return m_impl->m_checks_db;
 }
@@ -1091,22 +1320,60 @@ ClamPass::ClamPass():
 }
 
 void ClamPass::releaseMemory() {
-  m_ga->clear();
+  // The results are freed unless ClamAAWrapperPass still uses them
+  m_ga.reset();
+  m_cfg_builder_man.reset();
 }
 
-bool ClamPass::runOnModule(Module &M) {
-  /// Translate the module to Crab CFGs
+/* Set CFG builder parameters from command line options */
+static CrabBuilderParams getCrabBuilderParamsFromOptions() {
   CrabBuilderParams builder_params;
   builder_params.precision_level = CrabTrackLev;
   builder_params.simplify = CrabCFGSimplify;
   builder_params.lower_singleton_aliases = CrabEnableUniqueScalars;
   builder_params.include_useless_havoc = CrabIncludeHavoc;
   builder_params.enable_bignums = CrabEnableBignums;
+  builder_params.minimize_phi_copies = CrabMinimizePhiCopies;
+  builder_params.fold_edge_blocks = CrabFoldEdgeBlocks;
+  builder_params.max_global_init_table_size = CrabMaxGlobalInitTableSize;
   builder_params.add_pointer_assumptions = CrabAddPtrAssumptions;
   builder_params.check_only_typed_regions = CrabCheckOnlyTyped;
   builder_params.check_only_noncyclic_regions = CrabCheckOnlyNonCyclic;
   builder_params.print_cfg = CrabPrintCFG;
   builder_params.dot_cfg = CrabDotCFG;
+  return builder_params;
+}
+
+/* Set analysis parameters from command line options */
+static AnalysisParams getAnalysisParamsFromOptions() {
+  AnalysisParams params;
+  params.dom = ClamDomain;
+  params.run_backward = CrabBackward;
+  params.run_inter = CrabInter;
+  params.max_calling_contexts = CrabInterMaxSummaries;
+  params.analyze_recursive_functions = CrabInterRecursiveFunctions;
+  params.exact_summary_reuse = CrabInterExactSummaryReuse;
+  params.inter_entry_main = CrabInterStartFromMain;
+  params.run_liveness = CrabLive;
+  params.relational_threshold = CrabRelationalThreshold;
+  params.widening_delay = CrabWideningDelay;
+  params.narrowing_iters = CrabNarrowingIters;
+  params.widening_jumpset = CrabWideningJumpSet;
+  params.stats = crab::CrabStatsFlag /*CrabStats*/;
+  params.print_invars = CrabPrintInvariants;
+  params.print_unjustified_assumptions = CrabPrintUnjustifiedAssumptions;
+  params.store_invariants = CrabStoreInvariants;
+  params.store_stmt_invariants = CrabStoreStmtInvariants;
+  params.stream_functions = CrabStreamFunctions;
+  params.keep_shadow_vars = CrabKeepShadows;
+  params.check = CrabCheck;
+  params.check_verbose = CrabCheckVerbose;
+  return params;
+}
+  
+bool ClamPass::runOnModule(Module &M) {
+  /// Translate the module to Crab CFGs
+  CrabBuilderParams builder_params = getCrabBuilderParamsFromOptions();
   
   auto &tli = getAnalysis<TargetLibraryInfoWrapperPass>();
 
@@ -1158,36 +1425,51 @@ bool ClamPass::runOnModule(Module &M) {
 
   /// Run the analysis
 
-  m_params.dom = ClamDomain;
-  m_params.run_backward = CrabBackward;
-  m_params.run_inter = CrabInter;
-  m_params.max_calling_contexts = CrabInterMaxSummaries;
-  m_params.analyze_recursive_functions = CrabInterRecursiveFunctions;
-  m_params.exact_summary_reuse = CrabInterExactSummaryReuse;
-  m_params.inter_entry_main = CrabInterStartFromMain;
-  m_params.run_liveness = CrabLive;
-  m_params.relational_threshold = CrabRelationalThreshold;
-  m_params.widening_delay = CrabWideningDelay;
-  m_params.narrowing_iters = CrabNarrowingIters;
-  m_params.widening_jumpset = CrabWideningJumpSet;
-  m_params.stats = crab::CrabStatsFlag /*CrabStats*/;
-  m_params.print_invars = CrabPrintInvariants;
-  m_params.print_unjustified_assumptions = CrabPrintUnjustifiedAssumptions;
-  m_params.store_invariants = CrabStoreInvariants;
-  m_params.keep_shadow_vars = CrabKeepShadows;
-  m_params.check = CrabCheck;
-  m_params.check_verbose = CrabCheckVerbose;
+  m_params = getAnalysisParamsFromOptions();
+
+  std::unique_ptr<llvm::raw_fd_ostream> rangesOut;
+  if (!CrabExportRanges.empty()) {
+    std::error_code ec;
+    rangesOut = std::make_unique<llvm::raw_fd_ostream>(CrabExportRanges, ec,
+                                                       llvm::sys::fs::F_Text);
+    if (ec) {
+      CLAM_WARNING("cannot open " << CrabExportRanges << ": " << ec.message());
+      rangesOut.reset();
+    }
+  }
 
+  const bool streaming = m_params.stream_functions && !m_params.run_inter;
   if (m_params.run_inter) {
     m_ga.reset(new InterGlobalClam(M, *m_cfg_builder_man));
   } else {
-    m_ga.reset(new IntraGlobalClam(M, *m_cfg_builder_man));
+    auto intra = std::make_unique<IntraGlobalClam>(M, *m_cfg_builder_man);
+    if (streaming && rangesOut) {
+      // The results of each function are released after its analysis
+      // so they must be exported right away.
+      llvm::raw_fd_ostream &o = *rangesOut;
+      intra->setAnalyzedFunctionCallback(
+          [&o](const Function &F, IntraGlobalClam &ga) {
+            ClamRangeTable table(F, ga);
+            table.write(F, o);
+          });
+    }
+    m_ga = std::move(intra);
   }
   abs_dom_map_t abs_dom_assumptions /*no assumptions*/;    
   m_ga->analyze(m_params, abs_dom_assumptions);
 
-  
-  if (builder_params.dot_cfg) {
+  if (rangesOut && !streaming) {
+    ClamRangeTable table(M, *m_ga);
+    CRAB_VERBOSE_IF(1, crab::get_msg_stream()
+                           << "Exporting " << table.size() << " ranges to "
+                           << CrabExportRanges << "\n";);
+    table.write(M, *rangesOut);
+  }
+
+  if (builder_params.dot_cfg && streaming) {
+    CLAM_WARNING("CFGs are not printed because they are released after "
+                 "each function is analyzed");
+  } else if (builder_params.dot_cfg) {
     for (auto &F : M) {
       if (m_cfg_builder_man->hasCfg(F)) {
         cfg_t &cfg = m_cfg_builder_man->getCfg(F);
@@ -1242,6 +1524,16 @@ bool ClamPass::runOnModule(Module &M) {
     }
   }
 
+  if (auto *aa = getAnalysisIfAvailable<ClamAAWrapperPass>()) {
+    if (streaming) {
+      CLAM_WARNING("Clam alias analysis is not available because the "
+                   "results are released after each function is analyzed");
+      aa->setClamResults(M, nullptr, nullptr);
+    } else {
+      aa->setClamResults(M, m_cfg_builder_man, m_ga);
+    }
+  }
+
   return false;
 }
 
@@ -1304,6 +1596,12 @@ ClamPass::getPost(const llvm::BasicBlock *block, bool keep_shadows) const {
   return m_ga->getPost(block, keep_shadows);  
 }
 
+// return invariants that hold after I if they were stored
+llvm::Optional<clam_abstract_domain>
+ClamPass::getPostStmt(const llvm::Instruction *I, bool keep_shadows) const {
+  return m_ga->getPostStmt(I, keep_shadows);
+}
+
 bool ClamPass::hasFeasibleEdge(const llvm::BasicBlock *b1,
                                const llvm::BasicBlock *b2) const {
   return m_ga->hasFeasibleEdge(b1, b2);
@@ -1345,6 +1643,346 @@ void ClamPass::printChecks(raw_ostream &o) const {
     << warning << std::string(2, ' ') << "Number of total warning checks\n";
 }
 
+/*****************************************************************/
+/*              New pass manager analysis                        */
+/*****************************************************************/
+
+// Clam requires at most one return per function
+static bool hasAtMostOneReturn(const Function &f) {
+  unsigned numRets = 0;
+  for (auto &B : f) {
+    if (isa<ReturnInst>(B.getTerminator())) {
+      ++numRets;
+    }
+  }
+  return numRets <= 1;
+}
+
+// Return the function where v is defined if any
+static const Function *getParentFunction(const Value *v) {
+  if (!v) {
+    return nullptr;
+  } else if (auto I = dyn_cast<const Instruction>(v)) {
+    return I->getParent()->getParent();
+  } else if (auto A = dyn_cast<const Argument>(v)) {
+    return A->getParent();
+  }
+  return nullptr;
+}
+
+// Return a hash of the instructions of f and their operands. It
+// changes if an instruction is added, removed or moved, if its
+// opcode, type, flags or predicate change, or if any of its operands
+// is replaced. Integer and floating point constants are hashed by
+// value and the other operands by address.
+std::size_t getFunctionFingerprint(const Function &f) {
+  hash_code h = hash_value(f.size());
+  for (auto &B : f) {
+    h = hash_combine(h, &B);
+    for (auto &I : B) {
+      h = hash_combine(h, &I, I.getOpcode(), I.getType(),
+                       I.getRawSubclassOptionalData());
+      if (auto CI = dyn_cast<CmpInst>(&I)) {
+        h = hash_combine(h, CI->getPredicate());
+      }
+      for (const Use &U : I.operands()) {
+        const Value *v = U.get();
+        h = hash_combine(h, v, v->getType());
+        if (auto C = dyn_cast<ConstantInt>(v)) {
+          h = hash_combine(h, C->getValue());
+        } else if (auto C = dyn_cast<ConstantFP>(v)) {
+          h = hash_combine(h, C->getValueAPF());
+        }
+      }
+    }
+  }
+  return h;
+}
+
+ClamAnalysisResult::ClamAnalysisResult(Module &M,
+                                       std::unique_ptr<HeapAbstraction> mem)
+  : m_tli(new TargetLibraryInfoWrapperPass(Triple(M.getTargetTriple()))),
+    m_cfg_builder_man(nullptr), m_ga(nullptr) {
+  m_cfg_builder_man.reset(new CrabBuilderManager(
+      getCrabBuilderParamsFromOptions(), *m_tli, std::move(mem)));
+  m_params = getAnalysisParamsFromOptions();
+  // invariants are needed to answer queries
+  m_params.store_invariants = true;
+  m_params.stream_functions = false;
+  if (m_params.run_inter) {
+    m_ga.reset(new InterGlobalClam(M, *m_cfg_builder_man));
+  } else {
+    m_ga.reset(new IntraGlobalClam(M, *m_cfg_builder_man));
+  }
+  abs_dom_map_t abs_dom_assumptions /*no assumptions*/;
+  m_ga->analyze(m_params, abs_dom_assumptions);
+  for (auto &F : M) {
+    if (!F.empty()) {
+      setFingerprint(F);
+    }
+  }
+}
+
+ClamAnalysisResult::ClamAnalysisResult(ClamAnalysisResult &&o) = default;
+
+ClamAnalysisResult::~ClamAnalysisResult() = default;
+
+CrabBuilderManager &ClamAnalysisResult::getCfgBuilderMan() {
+  return *m_cfg_builder_man;
+}
+
+bool ClamAnalysisResult::supportsIncrementalUpdates() const {
+  // The call graph of the inter-procedural analysis keeps pointers to
+  // the CFGs of all functions and the heap abstraction is not updated
+  // after the IR is modified.
+  return !m_params.run_inter &&
+         m_cfg_builder_man->getHeapAbstraction().getClassId() ==
+             HeapAbstraction::ClassId::DUMMY;
+}
+
+bool ClamAnalysisResult::hasChanged(const Function &f) const {
+  if (f.empty()) {
+    return false;
+  }
+  auto it = m_fingerprints.find(&f);
+  // The handle is null if the analyzed function was deleted and f has
+  // been allocated at its address.
+  return (it == m_fingerprints.end() || it->second.m_fn != &f ||
+          it->second.m_hash != getFunctionFingerprint(f));
+}
+
+void ClamAnalysisResult::setFingerprint(const Function &f) const {
+  Fingerprint &fp = m_fingerprints[&f];
+  fp.m_fn = const_cast<Function *>(&f);
+  fp.m_hash = getFunctionFingerprint(f);
+}
+
+bool ClamAnalysisResult::isUpToDate(const Function &f) const {
+  return m_modified.count(&f) || !hasChanged(f);
+}
+
+bool ClamAnalysisResult::isReanalyzed(const Function &f) const {
+  return m_modified.count(&f) || m_reanalyzed.count(&f);
+}
+
+void ClamAnalysisResult::reanalyze(const Function &f) const {
+  assert(supportsIncrementalUpdates());
+  m_reanalyzed.erase(&f);
+  setFingerprint(f);
+
+  if (!isTrackable(f) || !hasAtMostOneReturn(f)) {
+    // f cannot be translated anymore so nothing is known about it.
+    m_reanalyzed[&f] = nullptr;
+    return;
+  }
+  
+  CRAB_VERBOSE_IF(1, crab::get_msg_stream()
+                         << "Re-analyzing modified function "
+                         << f.getName().str() << "\n";);
+  m_cfg_builder_man->resetCfgBuilder(f);
+  AnalysisParams params = m_params;
+  params.run_inter = false;
+  params.print_invars = false;
+  params.print_unjustified_assumptions = false;
+  params.check = CheckerKind::NOCHECKS;
+  auto intra = std::make_unique<IntraClam>(f, *m_cfg_builder_man);
+  intra->analyze(params);
+  m_reanalyzed[&f] = std::move(intra);
+}
+
+const std::unique_ptr<IntraClam> *
+ClamAnalysisResult::getReanalysis(const Function &f) const {
+  if (m_modified.erase(&f)) {
+    reanalyze(f);
+  }
+  auto it = m_reanalyzed.find(&f);
+  return (it != m_reanalyzed.end() ? &(it->second) : nullptr);
+}
+
+std::function<Optional<clam_abstract_domain>(const BasicBlock *)>
+ClamAnalysisResult::getPreFn() const {
+  return [this](const BasicBlock *b) { return getPre(b, false); };
+}
+
+ClamQueryCache &ClamAnalysisResult::getQueryCache(const Function &f) {
+  auto &cache = m_query_caches[&f];
+  if (!cache) {
+    cache = std::make_unique<ClamQueryCache>(
+        *m_cfg_builder_man,
+        [this](const Instruction *I) { return getPostStmt(I, false); });
+  }
+  return *cache;
+}
+
+llvm::Optional<clam_abstract_domain>
+ClamAnalysisResult::getPre(const BasicBlock *b, bool keep_shadows) const {
+  if (auto intra = getReanalysis(*(b->getParent()))) {
+    if (!*intra) {
+      return llvm::None;
+    }
+    return (*intra)->getPre(b, keep_shadows);
+  }
+  return m_ga->getPre(b, keep_shadows);
+}
+
+llvm::Optional<clam_abstract_domain>
+ClamAnalysisResult::getPost(const BasicBlock *b, bool keep_shadows) const {
+  if (auto intra = getReanalysis(*(b->getParent()))) {
+    if (!*intra) {
+      return llvm::None;
+    }
+    return (*intra)->getPost(b, keep_shadows);
+  }
+  return m_ga->getPost(b, keep_shadows);
+}
+
+llvm::Optional<clam_abstract_domain>
+ClamAnalysisResult::getPostStmt(const Instruction *I, bool keep_shadows) const {
+  if (auto intra = getReanalysis(*(I->getParent()->getParent()))) {
+    if (!*intra) {
+      return llvm::None;
+    }
+    return (*intra)->getPostStmt(I, keep_shadows);
+  }
+  return m_ga->getPostStmt(I, keep_shadows);
+}
+
+bool ClamAnalysisResult::hasFeasibleEdge(const BasicBlock *b1,
+                                         const BasicBlock *b2) const {
+  if (auto intra = getReanalysis(*(b1->getParent()))) {
+    return (!*intra || (*intra)->hasFeasibleEdge(b1, b2));
+  }
+  return m_ga->hasFeasibleEdge(b1, b2);
+}
+
+bool ClamAnalysisResult::invalidate(Module &M, const PreservedAnalyses &PA,
+                                    ModuleAnalysisManager::Invalidator &) {
+  auto PAC = PA.getChecker<ClamAnalysis>();
+  if (PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Module>>()) {
+    return false;
+  }
+  // A module transformation might have changed anything
+  if (!PA.getChecker<FunctionAnalysisManagerModuleProxy>().preserved()) {
+    return true;
+  }
+  // Only function transformations: find the modified functions
+  std::vector<const Function *> modified;
+  for (auto &F : M) {
+    if (!isUpToDate(F)) {
+      modified.push_back(&F);
+    }
+  }
+  if (modified.empty()) {
+    return false;
+  }
+  if (!supportsIncrementalUpdates()) {
+    return true;
+  }
+  // The modified functions are re-analyzed by the next query about
+  // them. Their cached answers are stale already.
+  for (const Function *F : modified) {
+    m_modified.insert(F);
+    m_query_caches.erase(F);
+  }
+  return false;
+}
+
+AliasResult ClamAnalysisResult::alias(const MemoryLocation &l1,
+                                      const MemoryLocation &l2,
+                                      AAQueryInfo &AAQI) {
+  const Function *f = getParentFunction(l1.Ptr);
+  if (!f) {
+    f = getParentFunction(l2.Ptr);
+  }
+  if (!f) {
+    return AliasResult::MayAlias;
+  }
+  return getQueryCache(*f).alias(l1, l2, AAQI, getPreFn());
+}
+
+ClamQueryAPI::Range ClamAnalysisResult::range(const Instruction &I) {
+  const BasicBlock *B = I.getParent();
+  return getQueryCache(*(B->getParent())).range(I, getPreFn());
+}
+
+ClamQueryAPI::Range ClamAnalysisResult::range(const BasicBlock &B,
+                                              const Value &V) {
+  return getQueryCache(*(B.getParent())).range(B, V, getPreFn());
+}
+
+Optional<ClamQueryAPI::TagVector>
+ClamAnalysisResult::tags(const Instruction &I) {
+  const BasicBlock *B = I.getParent();
+  return getQueryCache(*(B->getParent())).tags(I, getPreFn());
+}
+
+Optional<ClamQueryAPI::TagVector>
+ClamAnalysisResult::tags(const BasicBlock &B, const Value &V) {
+  return getQueryCache(*(B.getParent())).tags(B, V, getPreFn());
+}
+
+AnalysisKey ClamAnalysis::Key;
+
+ClamAnalysis::ClamAnalysis(HeapAbstractionFactory factory)
+  : m_mem_factory(factory) {}
+
+ClamAnalysis::Result ClamAnalysis::run(Module &M,
+                                       ModuleAnalysisManager &MAM) {
+  std::unique_ptr<HeapAbstraction> mem;
+  if (m_mem_factory) {
+    mem = m_mem_factory(M, MAM);
+  }
+  if (!mem) {
+    CLAM_WARNING("running clam without heap analysis");
+    mem.reset(new DummyHeapAbstraction());
+  }
+  return ClamAnalysisResult(M, std::move(mem));
+}
+
+AnalysisKey ClamFunctionAnalysis::Key;
+
+ClamFunctionAnalysis::Result
+ClamFunctionAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+  auto &MAMProxy = FAM.getResult<ModuleAnalysisManagerFunctionProxy>(F);
+  const ClamAnalysisResult *clam =
+      MAMProxy.getCachedResult<ClamAnalysis>(*F.getParent());
+  if (!clam) {
+    return Result(nullptr);
+  }
+  MAMProxy.registerOuterAnalysisInvalidation<ClamAnalysis,
+                                             ClamFunctionAnalysis>();
+  // The invariants of F are stale until ClamAnalysis is updated
+  return Result(clam->isUpToDate(F) ? clam : nullptr);
+}
+
+bool ClamFunctionAnalysis::Result::invalidate(
+    Function &F, const PreservedAnalyses &PA,
+    FunctionAnalysisManager::Invalidator &) {
+  auto PAC = PA.getChecker<ClamFunctionAnalysis>();
+  return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>());
+}
+
+PreservedAnalyses ClamPrinterPass::run(Module &M,
+                                       ModuleAnalysisManager &MAM) {
+  ClamAnalysisResult &clam = MAM.getResult<ClamAnalysis>(M);
+  for (auto &F : M) {
+    if (F.empty()) {
+      continue;
+    }
+    m_os << "Function " << F.getName() << ": "
+         << (clam.isReanalyzed(F) ? "re-analyzed" : "kept") << "\n";
+    for (auto &B : F) {
+      auto RI = dyn_cast<ReturnInst>(B.getTerminator());
+      if (RI && RI->getReturnValue() &&
+          RI->getReturnValue()->getType()->isIntegerTy()) {
+        ClamQueryAPI::Range r = clam.range(B, *(RI->getReturnValue()));
+        m_os << "  ret [" << r.first << ", " << r.second << "]\n";
+      }
+    }
+  }
+  return PreservedAnalyses::all();
+}
+
 #ifdef INCLUDE_ALL_DOMAINS
 REGISTER_DOMAIN(CrabDomain::INTERVALS, interval_domain_t)
 REGISTER_DOMAIN(CrabDomain::ZONES_SPLIT_DBM, split_dbm_domain_t)
@@ -0,0 +1,83 @@
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include "clam/Clam.hh"
+#include "clam/ClamAliasAnalysis.hh"
+#include "clam/ClamQueryAPI.hh"
+
+using namespace llvm;
+
+namespace clam {
+
+AliasResult ClamAAResult::alias(const MemoryLocation &LocA,
+                                const MemoryLocation &LocB,
+                                AAQueryInfo &AAQI) {
+  AliasResult res = m_clam.alias(LocA, LocB, AAQI);
+  if (res == AliasResult::NoAlias) {
+    return res;
+  }
+  // Forward the query to the next alias analysis
+  return AAResultBase::alias(LocA, LocB, AAQI);
+}
+
+ClamAAWrapperPass::ClamAAWrapperPass()
+    : ImmutablePass(ID), m_cfg_builder_man(nullptr), m_ga(nullptr),
+      m_result(nullptr) {}
+
+void ClamAAWrapperPass::setClamResults(
+    Module &M, std::shared_ptr<CrabBuilderManager> cfg_builder_man,
+    std::shared_ptr<ClamGlobalAnalysis> ga) {
+  m_result.reset();
+  m_fingerprints.clear();
+  m_cfg_builder_man = cfg_builder_man;
+  m_ga = ga;
+  if (!m_ga) {
+    return;
+  }
+  m_result.reset(new ClamAAResult(*m_ga));
+  for (auto &F : M) {
+    if (!F.empty()) {
+      Fingerprint &fp = m_fingerprints[&F];
+      fp.m_fn = &F;
+      fp.m_hash = getFunctionFingerprint(F);
+    }
+  }
+}
+
+ClamAAResult *ClamAAWrapperPass::getResult(const Function &F) {
+  if (!m_result) {
+    return nullptr;
+  }
+  auto it = m_fingerprints.find(&F);
+  if (it == m_fingerprints.end() || it->second.m_fn != &F ||
+      it->second.m_hash != getFunctionFingerprint(F)) {
+    return nullptr;
+  }
+  return m_result.get();
+}
+
+void ClamAAWrapperPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+}
+
+char ClamAAWrapperPass::ID = 0;
+
+llvm::Pass *createClamAAWrapperPass() { return new ClamAAWrapperPass(); }
+
+// Add ClamAAResult to the alias analyses used by LLVM passes on F if
+// ClamPass has analyzed F and F has not been modified since then.
+llvm::Pass *createClamExternalAAWrapperPass() {
+  return createExternalAAWrapperPass([](Pass &P, Function &F, AAResults &AAR) {
+    if (auto *WrapperPass = P.getAnalysisIfAvailable<ClamAAWrapperPass>()) {
+      if (ClamAAResult *Result = WrapperPass->getResult(F)) {
+        AAR.addAAResult(*Result);
+      }
+    }
+  });
+}
+
+} // end namespace clam
+
+static RegisterPass<clam::ClamAAWrapperPass>
+X("clam-aa", "Alias analysis based on Clam regions and tags", false, true);
@@ -0,0 +1,58 @@
+#include "llvm/IR/Instruction.h"
+
+#include "clam/ClamInvariants.hh"
+#include "crab/analysis/abs_transformer.hpp"
+
+namespace clam {
+
+using abs_tr_t =
+    crab::analyzer::intra_abs_transformer<basic_block_t, clam_abstract_domain>;
+
+const llvm::Instruction *getDefInst(const statement_t &s) {
+  if (s.get_live().num_defs() == 1) {
+    var_t v = *(s.get_live().defs_begin());
+    if (v.name().get()) {
+      return llvm::dyn_cast<const llvm::Instruction>(*(v.name().get()));
+    }
+  }
+  return nullptr;
+}
+
+llvm::Optional<ClamQueryAPI::Range> getInt64Range(clam_abstract_domain &inv,
+                                                  const var_t &v) {
+  auto interval = inv[v];
+  if (interval.is_bottom() || !interval.lb().is_finite() ||
+      !interval.ub().is_finite()) {
+    return llvm::None;
+  }
+  auto min = *(interval.lb().number());
+  auto max = *(interval.ub().number());
+  if (!min.fits_int64() || !max.fits_int64()) {
+    return llvm::None;
+  }
+  return std::make_pair((int64_t)min, (int64_t)max);
+}
+
+void forEachStmtPost(basic_block_t &bb, clam_abstract_domain pre,
+                     StmtInvariantFn fn) {
+  abs_tr_t vis(pre);
+  for (auto &s : bb) {
+    s.accept(&vis); // propagate the invariant one statement forward
+    if (!fn(s, vis.get_abs_value())) {
+      break;
+    }
+  }
+}
+
+void forEachStmtPre(basic_block_t &bb, clam_abstract_domain pre,
+                    StmtInvariantFn fn) {
+  abs_tr_t vis(pre);
+  for (auto &s : bb) {
+    if (!fn(s, vis.get_abs_value())) {
+      break;
+    }
+    s.accept(&vis); // propagate the invariant one statement forward
+  }
+}
+
+} // end namespace clam
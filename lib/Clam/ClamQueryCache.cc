@@ -3,7 +3,10 @@
 #include "llvm/ADT/Optional.h"
 #include "ClamQueryCache.hh"
 #include "clam/CfgBuilder.hh"
-#include "crab/analysis/fwd_analyzer.hpp"
+#include "clam/ClamInvariants.hh"
+#include "clam/HeapAbstraction.hh"
+
+#include <algorithm>
 
 namespace clam {
 using namespace llvm;
@@ -13,162 +16,260 @@ static ClamQueryAPI::Range getFullRange() {
                         std::numeric_limits<int64_t>::max());
 }
 
-static bool match(const Instruction &I, statement_t &s) {
-  if (s.get_live().num_defs() == 1) {
-    var_t v = *(s.get_live().defs_begin());
-    if (v.name().get()) {
-      if (auto II = dyn_cast<const Instruction>(*(v.name().get()))) {
-        return II == &I;
+ClamQueryCache::ClamQueryCache(CrabBuilderManager &man,
+                               getPostStmtFn getPostStmt)
+    : m_crab_builder_man(man), m_get_post_stmt(getPostStmt) {}
+
+// Return the function where v is defined if any
+static const Function *getParentFunction(const Value &v) {
+  if (auto I = dyn_cast<const Instruction>(&v)) {
+    return I->getParent()->getParent();
+  } else if (auto A = dyn_cast<const Argument>(&v)) {
+    return A->getParent();
+  }
+  return nullptr;
+}
+
+// Return true if all the bytes accessed by loc are within rgn
+static bool fitsInRegion(const MemoryLocation &loc, const Region &rgn) {
+  if (rgn.isUnknown() || !loc.Size.hasValue()) {
+    return false;
+  }
+  unsigned bitwidth = rgn.getRegionInfo().getType().second;
+  return (bitwidth > 0 && loc.Size.getValue() * 8 <= bitwidth);
+}
+
+static bool disjointTags(ClamQueryAPI::TagVector t1,
+                         ClamQueryAPI::TagVector t2) {
+  std::sort(t1.begin(), t1.end());
+  std::sort(t2.begin(), t2.end());
+  std::vector<uint64_t> common;
+  std::set_intersection(t1.begin(), t1.end(), t2.begin(), t2.end(),
+                        std::back_inserter(common));
+  return common.empty();
+}
+
+Optional<ClamQueryAPI::TagVector>
+ClamQueryCache::tagsOf(const Value &V, const getPreFn &getPre) {
+  if (auto I = dyn_cast<const Instruction>(&V)) {
+    if (!cacheStoredInst(*I)) {
+      ensureBlockCached(*(I->getParent()), getPre);
+    }
+    return m_tag_inst_cache.lookup(I);
+  } else if (auto A = dyn_cast<const Argument>(&V)) {
+    const BasicBlock &entry = A->getParent()->getEntryBlock();
+    return computeTags(entry, V, getPre);
+  }
+  return None;
+}
+
+AliasResult ClamQueryCache::alias(const MemoryLocation &loc1,
+                                  const MemoryLocation &loc2, AAQueryInfo &,
+                                  const getPreFn &getPre) {
+  if (!loc1.Ptr || !loc2.Ptr) {
+    return AliasResult::MayAlias;
+  }
+  
+  const Function *F1 = getParentFunction(*loc1.Ptr);
+  const Function *F2 = getParentFunction(*loc2.Ptr);
+  if ((F1 && F2 && F1 != F2) || (!F1 && !F2)) {
+    return AliasResult::MayAlias;
+  }
+  const Function &F = (F1 ? *F1 : *F2);
+
+  if (m_crab_builder_man.getHeapAbstraction().mayDisambiguateUnsoundly()) {
+    // Neither different regions nor the tags tracked in them imply
+    // that the accesses do not overlap.
+    return AliasResult::MayAlias;
+  }
+
+  if (auto res = m_alias_cache.lookup({loc1, loc2})) {
+    return res.getValue();
+  }
+
+  std::lock_guard<std::mutex> lock(m_compute_mutex);
+  AliasResult res = AliasResult::MayAlias;
+  // Two accesses that fall completely within two different known
+  // regions cannot overlap.
+  HeapAbstraction &mem = m_crab_builder_man.getHeapAbstraction();
+  Region rgn1 = mem.getRegion(F, *loc1.Ptr);
+  Region rgn2 = mem.getRegion(F, *loc2.Ptr);
+  if (!(rgn1 == rgn2) && fitsInRegion(loc1, rgn1) && fitsInRegion(loc2, rgn2)) {
+    res = AliasResult::NoAlias;
+  } else if (m_crab_builder_man.getCfgBuilderParams().trackMemory()) {
+    // Two references with disjoint tags cannot point to the same
+    // memory object.
+    Optional<TagVector> tags1 = tagsOf(*loc1.Ptr, getPre);
+    if (tags1.hasValue() && !tags1.getValue().empty()) {
+      Optional<TagVector> tags2 = tagsOf(*loc2.Ptr, getPre);
+      if (tags2.hasValue() && !tags2.getValue().empty() &&
+          disjointTags(tags1.getValue(), tags2.getValue())) {
+        res = AliasResult::NoAlias;
       }
     }
   }
-  return false;
+
+  m_alias_cache.insert({loc1, loc2}, res);
+  m_alias_cache.insert({loc2, loc1}, res);
+  return res;
 }
 
-ClamQueryCache::ClamQueryCache(CrabBuilderManager &man)
-    : m_crab_builder_man(man) {}
+void ClamQueryCache::cacheBlock(const BasicBlock &BB,
+                                clam_abstract_domain invAtEntry) {
+  const Function &fParent = *(BB.getParent());
+  if (!m_crab_builder_man.hasCfg(fParent)) {
+    return;
+  }
+  auto &crabCfg = m_crab_builder_man.getCfg(fParent);
+  auto crabCfgBuilder = m_crab_builder_man.getCfgBuilder(fParent);
+  auto &crabBB = crabCfg.get_node(crabCfgBuilder->getCrabBasicBlock(&BB));
+  // A single sweep caches the results for all the instructions of
+  // the block so that clients that query every instruction of a
+  // block do not pay a quadratic cost.
+  DenseSet<const Instruction *> seen;
+  forEachStmtPost(crabBB, invAtEntry,
+                  [&](const statement_t &crabStmt, clam_abstract_domain &inv) {
+                    const Instruction *I = getDefInst(crabStmt);
+                    // Only the first statement that defines I is relevant.
+                    if (I && I->getParent() == &BB && seen.insert(I).second) {
+                      cacheInst(*I, crabCfgBuilder, inv);
+                    }
+                    return true;
+                  });
+}
 
-AliasResult ClamQueryCache::alias(const MemoryLocation &loc1,
-                                  const MemoryLocation &loc2, AAQueryInfo &) {
-  // TODO: implementation
-  return AliasResult::MayAlias;
+void ClamQueryCache::cacheInst(const Instruction &I,
+                               CfgBuilderPtr crabCfgBuilder,
+                               clam_abstract_domain &inv) {
+  const Function &fParent = *(I.getParent()->getParent());
+  if (I.getType()->isIntegerTy()) {
+    llvm::Optional<var_t> crabVar = crabCfgBuilder->getCrabVariable(I);
+    if (crabVar.hasValue()) {
+      if (auto interval = getInt64Range(inv, crabVar.getValue())) {
+        m_range_inst_cache.insert(&I, interval.getValue());
+      }
+    }
+  } else if (I.getType()->isPointerTy()) {
+    llvm::Optional<var_t> crabRefVar = crabCfgBuilder->getCrabVariable(I);
+    llvm::Optional<var_t> crabRgnVar =
+      crabCfgBuilder->getCrabRegionVariable(fParent, I);
+    if (crabRefVar.hasValue() && crabRgnVar.hasValue()) {
+      std::vector<uint64_t> tags;
+      if (inv.get_tags(crabRgnVar.getValue(), crabRefVar.getValue(), tags)) {
+        m_tag_inst_cache.insert(&I, tags);
+      }
+    }
+  }
 }
 
-ClamQueryAPI::Range
-ClamQueryCache::range(const llvm::Instruction &I,
-                      Optional<clam_abstract_domain> invAtEntry) {
-  auto it = m_range_inst_cache.find(&I);
-  if (it != m_range_inst_cache.end()) {
-    return it->second;
+bool ClamQueryCache::cacheStoredInst(const Instruction &I) {
+  if (m_cached_insts.contains(&I)) {
+    return true;
+  }
+  if (!m_get_post_stmt) {
+    return false;
+  }
+  const Function &fParent = *(I.getParent()->getParent());
+  if (!m_crab_builder_man.hasCfg(fParent)) {
+    return false;
+  }
+  Optional<clam_abstract_domain> inv = m_get_post_stmt(&I);
+  if (!inv.hasValue()) {
+    return false;
   }
+  cacheInst(I, m_crab_builder_man.getCfgBuilder(fParent), inv.getValue());
+  // Readers that see I here must see its range and tags so this must
+  // be the last insertion.
+  m_cached_insts.insert(&I, true);
+  return true;
+}
 
+void ClamQueryCache::ensureBlockCached(const BasicBlock &BB,
+                                       const getPreFn &getPre) {
+  if (m_cached_blocks.contains(&BB)) {
+    return;
+  }
+  Optional<clam_abstract_domain> invAtEntry = getPre(&BB);
   if (invAtEntry.hasValue()) {
-    const BasicBlock &BB = *(I.getParent());
-    const Function &fParent = *(BB.getParent());
-    if (m_crab_builder_man.hasCfg(fParent)) {
-      auto &crabCfg = m_crab_builder_man.getCfg(fParent);
-      auto crabCfgBuilder = m_crab_builder_man.getCfgBuilder(fParent);
-      auto &crabBB = crabCfg.get_node(crabCfgBuilder->getCrabBasicBlock(&BB));
-      // Forward propagation through the basic block but ignoring
-      // callsites. This might be imprecise if the analysis was
-      // inter-procedural because we cannot reconstruct all the context
-      // that the inter-procedural analysis had during the analysis.
-      using abs_tr_t =
-        crab::analyzer::intra_abs_transformer<basic_block_t,
-                                              clam_abstract_domain>;
-      abs_tr_t vis(invAtEntry.getValue());
-      for (auto &crabStmt : crabBB) {
-	crabStmt.accept(&vis); // propagate the invariant one statement forward
-	const clam_abstract_domain &nextInv = vis.get_abs_value();
-	if (match(I, crabStmt)) {
-	  llvm::Optional<var_t> crabVar = crabCfgBuilder->getCrabVariable(I);
-	  if (crabVar.hasValue()) {
-	    clam_abstract_domain tmp(nextInv);
-	    auto crabInterval = tmp[crabVar.getValue()];
-	    if (crabInterval.lb().is_finite() && crabInterval.ub().is_finite()) {
-	      auto min = *(crabInterval.lb().number());
-	      auto max = *(crabInterval.ub().number());
-	      if (min.fits_int64() && max.fits_int64()) {
-		auto interval = std::make_pair((int64_t)min, (int64_t)max);
-		m_range_inst_cache[&I] = interval;
-		return interval;
-	      }
-	    }
-	  }
-	}
-      }
+    cacheBlock(BB, invAtEntry.getValue());
+  }
+  // Readers that see BB here must see all its instructions so this
+  // must be the last insertion.
+  m_cached_blocks.insert(&BB, true);
+}
+
+ClamQueryAPI::Range ClamQueryCache::range(const llvm::Instruction &I,
+                                          const getPreFn &getPre) {
+  const BasicBlock &BB = *(I.getParent());
+  if (!m_cached_blocks.contains(&BB) && !m_cached_insts.contains(&I)) {
+    std::lock_guard<std::mutex> lock(m_compute_mutex);
+    if (!cacheStoredInst(I)) {
+      ensureBlockCached(BB, getPre);
     }
   }
+  if (auto res = m_range_inst_cache.lookup(&I)) {
+    return res.getValue();
+  }
   return getFullRange();
 }
 
-ClamQueryAPI::Range
-ClamQueryCache::range(const llvm::BasicBlock &BB, const llvm::Value &V,
-                      Optional<clam_abstract_domain> invAtEntry) {
-  auto it = m_range_value_cache.find({&BB, &V});
-  if (it != m_range_value_cache.end()) {
-    return it->second;
+ClamQueryAPI::Range ClamQueryCache::range(const llvm::BasicBlock &BB,
+                                          const llvm::Value &V,
+                                          const getPreFn &getPre) {
+  if (auto res = m_range_value_cache.lookup({&BB, &V})) {
+    return res.getValue().getValueOr(getFullRange());
   }
 
+  std::lock_guard<std::mutex> lock(m_compute_mutex);
+  // another thread might have cached it while we were waiting
+  if (auto res = m_range_value_cache.lookup({&BB, &V})) {
+    return res.getValue().getValueOr(getFullRange());
+  }
+  Optional<Range> res = None;
+  Optional<clam_abstract_domain> invAtEntry = getPre(&BB);
   if (invAtEntry.hasValue()) {
     const Function &F = *(BB.getParent());
     auto crabCfgBuilder = m_crab_builder_man.getCfgBuilder(F);    
     llvm::Optional<var_t> crabVar = crabCfgBuilder->getCrabVariable(V);
     if (crabVar.hasValue()) {
-      auto crabInterval = invAtEntry.getValue()[crabVar.getValue()];
-      if (crabInterval.lb().is_finite() && crabInterval.ub().is_finite()) {
-        auto min = *(crabInterval.lb().number());
-        auto max = *(crabInterval.ub().number());
-        if (min.fits_int64() && max.fits_int64()) {
-          auto interval = std::make_pair((int64_t)min, (int64_t)max);
-          auto k = std::make_pair(&BB, &V);
-          m_range_value_cache[k] = interval;
-          return interval;
-        }
-      }
+      res = getInt64Range(invAtEntry.getValue(), crabVar.getValue());
     }
   }
-  return getFullRange();
+  m_range_value_cache.insert({&BB, &V}, res);
+  return res.getValueOr(getFullRange());
 }
 
 Optional<ClamQueryAPI::TagVector>
-ClamQueryCache::tags(const llvm::Instruction &I,
-		     Optional<clam_abstract_domain> invAtEntry) {
-
-  auto it = m_tag_inst_cache.find(&I);
-  if (it != m_tag_inst_cache.end()) {
-    return it->second;
-  }
-  
-  if (invAtEntry.hasValue()) {
-    const BasicBlock &BB = *(I.getParent());
-    const Function &fParent = *(BB.getParent());
-    if (m_crab_builder_man.hasCfg(fParent)) {
-      auto &crabCfg = m_crab_builder_man.getCfg(fParent);
-      auto crabCfgBuilder = m_crab_builder_man.getCfgBuilder(fParent);
-      auto &crabBB = crabCfg.get_node(crabCfgBuilder->getCrabBasicBlock(&BB));
-      // Forward propagation through the basic block but ignoring
-      // callsites. This might be imprecise if the analysis was
-      // inter-procedural because we cannot reconstruct all the context
-      // that the inter-procedural analysis had during the analysis.
-      using abs_tr_t =
-        crab::analyzer::intra_abs_transformer<basic_block_t,
-                                              clam_abstract_domain>;
-      abs_tr_t vis(invAtEntry.getValue());
-      for (auto &crabStmt : crabBB) {
-	crabStmt.accept(&vis); // propagate the invariant one statement forward
-	const clam_abstract_domain &nextInv = vis.get_abs_value();
-	if (match(I, crabStmt)) {
-	  clam_abstract_domain tmp(nextInv);
-	  llvm::Optional<var_t> crabRefVar = crabCfgBuilder->getCrabVariable(I);
-	  llvm::Optional<var_t> crabRgnVar = crabCfgBuilder->getCrabRegionVariable(fParent, I);	
-	  if (crabRefVar.hasValue() && crabRgnVar.hasValue()) {
-	    std::vector<uint64_t> tags;
-	    bool known = invAtEntry.getValue().get_tags(crabRgnVar.getValue(),
-							crabRefVar.getValue(), tags);
-	    if (known) {
-	      m_tag_inst_cache[&I] = tags;
-	      return tags;
-	    } else {
-	      return None;
-	    }
-	  }
-	}
-      }
+ClamQueryCache::tags(const llvm::Instruction &I, const getPreFn &getPre) {
+  const BasicBlock &BB = *(I.getParent());
+  if (!m_cached_blocks.contains(&BB) && !m_cached_insts.contains(&I)) {
+    std::lock_guard<std::mutex> lock(m_compute_mutex);
+    if (!cacheStoredInst(I)) {
+      ensureBlockCached(BB, getPre);
     }
   }
-  return None;
+  return m_tag_inst_cache.lookup(&I);
 }
 
 Optional<ClamQueryAPI::TagVector>
 ClamQueryCache::tags(const llvm::BasicBlock &BB, const llvm::Value &V,
-		     Optional<clam_abstract_domain> invAtEntry) {
+		     const getPreFn &getPre) {
+  if (auto res = m_tag_value_cache.lookup({&BB, &V})) {
+    return res.getValue();
+  }
+  std::lock_guard<std::mutex> lock(m_compute_mutex);
+  return computeTags(BB, V, getPre);
+}
 
-  auto it = m_tag_value_cache.find({&BB, &V});
-  if (it != m_tag_value_cache.end()) {
-    return it->second;
+Optional<ClamQueryAPI::TagVector>
+ClamQueryCache::computeTags(const llvm::BasicBlock &BB, const llvm::Value &V,
+                            const getPreFn &getPre) {
+  if (auto res = m_tag_value_cache.lookup({&BB, &V})) {
+    return res.getValue();
   }
-  
+
+  Optional<TagVector> res = None;
+  Optional<clam_abstract_domain> invAtEntry = getPre(&BB);
   if (invAtEntry.hasValue()) {
     const Function &F = *(BB.getParent());
     CfgBuilderPtr cfgBuilder =  m_crab_builder_man.getCfgBuilder(F);
@@ -176,18 +277,14 @@ ClamQueryCache::tags(const llvm::BasicBlock &BB, const llvm::Value &V,
     llvm::Optional<var_t> crabRefVar = cfgBuilder->getCrabVariable(V);
     if (crabRgnVar.hasValue() && crabRefVar.hasValue()) {
       std::vector<uint64_t> tags;
-      bool known = invAtEntry.getValue().get_tags(crabRgnVar.getValue(),
-						  crabRefVar.getValue(), tags);
-      if (known) {
-	auto k = std::make_pair(&BB, &V);
-	m_tag_value_cache[k] = tags;
-	return tags;
-      } else {
-	return None;
+      if (invAtEntry.getValue().get_tags(crabRgnVar.getValue(),
+                                         crabRefVar.getValue(), tags)) {
+        res = tags;
       }
     }
   }
-  return None;
+  m_tag_value_cache.insert({&BB, &V}, res);
+  return res;
 }
 
 } // end namespace clam
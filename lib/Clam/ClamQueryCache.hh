@@ -5,8 +5,16 @@
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/Optional.h>
+#include <llvm/Support/MathExtras.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
 
 namespace llvm {
+class Function;
 class Instruction;
 class BasicBlock;
 class Value;
@@ -15,35 +23,148 @@ class Value;
 namespace clam {
 class CrabBuilderManager;
 
+/**
+ * A map split into shards, each one protected by its own
+ * reader-writer lock. Lookups on different shards never contend and
+ * lookups on the same shard only contend with inserts.
+ **/
+template <typename K, typename V, unsigned NumShards = 16>
+class ConcurrentCache {
+  struct Shard {
+    mutable std::shared_timed_mutex m_mutex;
+    llvm::DenseMap<K, V> m_map;
+  };
+  std::array<Shard, NumShards> m_shards;
+
+  static_assert(NumShards > 0 && (NumShards & (NumShards - 1)) == 0,
+                "the number of shards must be a power of two");
+
+  // The inner DenseMaps probe with the low bits of the hash so the
+  // shard is chosen from the high bits of a re-mixed hash. Otherwise,
+  // all the keys of a shard would share their low bits.
+  static unsigned getShardIndex(const K &k) {
+    if (NumShards == 1) {
+      return 0;
+    }
+    uint64_t h = llvm::DenseMapInfo<K>::getHashValue(k);
+    h *= 0x9e3779b97f4a7c15ULL;
+    return static_cast<unsigned>(h >> (64 - llvm::Log2_32(NumShards)));
+  }
+
+  Shard &getShard(const K &k) { return m_shards[getShardIndex(k)]; }
+  const Shard &getShard(const K &k) const {
+    return m_shards[getShardIndex(k)];
+  }
+
+public:
+  llvm::Optional<V> lookup(const K &k) const {
+    const Shard &shard = getShard(k);
+    std::shared_lock<std::shared_timed_mutex> lock(shard.m_mutex);
+    auto it = shard.m_map.find(k);
+    if (it != shard.m_map.end()) {
+      return it->second;
+    }
+    return llvm::None;
+  }
+
+  bool contains(const K &k) const {
+    const Shard &shard = getShard(k);
+    std::shared_lock<std::shared_timed_mutex> lock(shard.m_mutex);
+    return shard.m_map.count(k) > 0;
+  }
+
+  void insert(const K &k, const V &v) {
+    Shard &shard = getShard(k);
+    std::unique_lock<std::shared_timed_mutex> lock(shard.m_mutex);
+    shard.m_map[k] = v;
+  }
+};
+
+/**
+ * Cache for ClamQueryAPI queries.
+ *
+ * All public methods are thread-safe. Cache hits only take a shared
+ * lock on one shard. Unknown results are cached too. Misses are
+ * computed while holding a single mutex because Crab (abstract
+ * domains, statistics, variable factory) and the heap abstraction
+ * are not thread-safe. For the same reason, getPre is only called
+ * while holding that mutex.
+ **/
 class ClamQueryCache {
+public:
   using Range = typename ClamQueryAPI::Range;
   using TagVector = typename ClamQueryAPI::TagVector;
+  /* return the invariants that hold at the entry of a block */
+  using getPreFn = std::function<llvm::Optional<clam_abstract_domain>(
+      const llvm::BasicBlock *)>;
+  /* return the invariants stored after an instruction if any */
+  using getPostStmtFn = std::function<llvm::Optional<clam_abstract_domain>(
+      const llvm::Instruction *)>;
+
+private:
+  using BlockValue = std::pair<const llvm::BasicBlock *, const llvm::Value *>;
+  using LocPair = std::pair<llvm::MemoryLocation, llvm::MemoryLocation>;
   
   CrabBuilderManager &m_crab_builder_man;
+  getPostStmtFn m_get_post_stmt;
+  // Serialize all the computations done by Crab and the heap abstraction
+  std::mutex m_compute_mutex;
   
-  llvm::DenseMap<
-      std::pair<const llvm::MemoryLocation *, const llvm::MemoryLocation *>,
-      llvm::AliasResult> m_alias_cache;
-  llvm::DenseMap<const llvm::Instruction *, Range> m_range_inst_cache;
-  llvm::DenseMap<std::pair<const llvm::BasicBlock *, const llvm::Value *>,
-                 Range> m_range_value_cache;
-  llvm::DenseMap<const llvm::Instruction *, TagVector> m_tag_inst_cache;
-  llvm::DenseMap<std::pair<const llvm::BasicBlock *, const llvm::Value *>,
-                 TagVector> m_tag_value_cache;
+  ConcurrentCache<LocPair, llvm::AliasResult> m_alias_cache;
+  ConcurrentCache<const llvm::Instruction *, Range> m_range_inst_cache;
+  // None if the range or tags are unknown
+  ConcurrentCache<BlockValue, llvm::Optional<Range>> m_range_value_cache;
+  ConcurrentCache<const llvm::Instruction *, TagVector> m_tag_inst_cache;
+  ConcurrentCache<BlockValue, llvm::Optional<TagVector>> m_tag_value_cache;
+  // Blocks whose instructions have been already cached in
+  // m_range_inst_cache and m_tag_inst_cache. A block is inserted
+  // only after all its instructions.
+  ConcurrentCache<const llvm::BasicBlock *, bool> m_cached_blocks;
+  // Instructions cached from the invariants stored after them by the
+  // analysis.
+  ConcurrentCache<const llvm::Instruction *, bool> m_cached_insts;
+
+  // Propagate invAtEntry through the whole Crab block of BB and cache
+  // the range and tags of each instruction defined in BB.
+  void cacheBlock(const llvm::BasicBlock &BB, clam_abstract_domain invAtEntry);
+
+  // Cache the range and tags of I from inv, the invariants after I.
+  void cacheInst(const llvm::Instruction &I, CfgBuilderPtr crabCfgBuilder,
+                 clam_abstract_domain &inv);
+
+  /* The caller of the methods below must hold m_compute_mutex */
+  
+  // Make sure that the instructions of BB are cached.
+  void ensureBlockCached(const llvm::BasicBlock &BB, const getPreFn &getPre);
+
+  // Cache I from the invariants stored after I. Return false if the
+  // analysis did not store them.
+  bool cacheStoredInst(const llvm::Instruction &I);
+
+  // Return the tags of the reference V if known.
+  llvm::Optional<TagVector> tagsOf(const llvm::Value &V, const getPreFn &getPre);
+
+  // Return the tags of the reference V at the entry of B if known.
+  llvm::Optional<TagVector> computeTags(const llvm::BasicBlock &B,
+                                        const llvm::Value &V,
+                                        const getPreFn &getPre);
   
 public:
-  ClamQueryCache(CrabBuilderManager &man);
+  ClamQueryCache(CrabBuilderManager &man,
+                 getPostStmtFn getPostStmt = getPostStmtFn());
+  // NoAlias if the two locations belong to disjoint regions or their
+  // pointers have disjoint tags.
   llvm::AliasResult alias(const llvm::MemoryLocation &loc1,
                           const llvm::MemoryLocation &loc2,
-                          llvm::AAQueryInfo &AAQI);
-  Range range(const llvm::Instruction &I,
-              llvm::Optional<clam_abstract_domain> invAtEntry);
+                          llvm::AAQueryInfo &AAQI,
+                          const getPreFn &getPre);
+  Range range(const llvm::Instruction &I, const getPreFn &getPre);
   Range range(const llvm::BasicBlock &B, const llvm::Value &V,
-              llvm::Optional<clam_abstract_domain> invAtEntry);
+              const getPreFn &getPre);
   llvm::Optional<TagVector> tags(const llvm::Instruction &I,
-	      llvm::Optional<clam_abstract_domain> invAtEntry);
+                                 const getPreFn &getPre);
   llvm::Optional<TagVector> tags(const llvm::BasicBlock &B, const llvm::Value &V,
-              llvm::Optional<clam_abstract_domain> invAtEntry);
+                                 const getPreFn &getPre);
   
 };
 } // end namespace clam
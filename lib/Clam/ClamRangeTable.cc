@@ -0,0 +1,143 @@
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "clam/CfgBuilder.hh"
+#include "clam/Clam.hh"
+#include "clam/ClamInvariants.hh"
+#include "clam/ClamRangeTable.hh"
+
+#include <algorithm>
+
+namespace clam {
+using namespace llvm;
+
+static bool compareEntry(const ClamRangeTable::Entry &e1,
+                         const ClamRangeTable::Entry &e2) {
+  return e1.value < e2.value;
+}
+
+// Add an entry for v if its interval in inv is finite and fits in int64_t
+static void addEntry(std::vector<ClamRangeTable::Entry> &table,
+                     CfgBuilder &builder, clam_abstract_domain &inv,
+                     const Value &v) {
+  llvm::Optional<var_t> crabVar = builder.getCrabVariable(v);
+  if (!crabVar.hasValue()) {
+    return;
+  }
+  if (auto r = getInt64Range(inv, crabVar.getValue())) {
+    table.push_back({&v, r.getValue().first, r.getValue().second});
+  }
+}
+
+ClamRangeTable::ClamRangeTable(const Module &M, ClamGlobalAnalysis &ga) {
+  for (auto &F : M) {
+    addFunction(F, ga);
+  }
+  sortTable();
+}
+
+ClamRangeTable::ClamRangeTable(const Function &F, ClamGlobalAnalysis &ga) {
+  addFunction(F, ga);
+  sortTable();
+}
+
+void ClamRangeTable::addFunction(const Function &F, ClamGlobalAnalysis &ga) {
+  CrabBuilderManager &man = ga.getCfgBuilderMan();
+
+  if (!man.hasCfg(F)) {
+    return;
+  }
+  CfgBuilderPtr builder = man.getCfgBuilder(F);
+  cfg_t &cfg = man.getCfg(F);
+  for (auto &BB : F) {
+    llvm::Optional<clam_abstract_domain> pre = ga.getPre(&BB, false);
+    if (!pre.hasValue() || pre.getValue().is_bottom()) {
+      continue;
+    }
+
+    if (&BB == &F.getEntryBlock()) {
+      for (auto &Arg : F.args()) {
+        if (Arg.getType()->isIntegerTy()) {
+          addEntry(m_table, *builder, pre.getValue(), Arg);
+        }
+      }
+    }
+
+    auto &crabBB = cfg.get_node(builder->getCrabBasicBlock(&BB));
+    forEachStmtPost(crabBB, pre.getValue(),
+                    [&](const statement_t &crabStmt, clam_abstract_domain &inv) {
+                      const Instruction *I = getDefInst(crabStmt);
+                      if (I && I->getParent() == &BB &&
+                          I->getType()->isIntegerTy()) {
+                        addEntry(m_table, *builder, inv, *I);
+                      }
+                      return true;
+                    });
+  }
+}
+
+void ClamRangeTable::sortTable() {
+  // Only the first statement that defines a value is relevant. A
+  // stable sort keeps that entry at the front of its equal range.
+  std::stable_sort(m_table.begin(), m_table.end(), compareEntry);
+  m_table.erase(std::unique(m_table.begin(), m_table.end(),
+                            [](const Entry &e1, const Entry &e2) {
+                              return e1.value == e2.value;
+                            }),
+                m_table.end());
+  m_table.shrink_to_fit();
+}
+
+llvm::Optional<ClamRangeTable::Range>
+ClamRangeTable::lookup(const Value &v) const {
+  Entry key = {&v, 0, 0};
+  auto it = std::lower_bound(m_table.begin(), m_table.end(), key, compareEntry);
+  if (it != m_table.end() && it->value == &v) {
+    return std::make_pair(it->lo, it->hi);
+  }
+  return None;
+}
+
+ClamRangeTable::Range ClamRangeTable::range(const Value &v) const {
+  llvm::Optional<Range> res = lookup(v);
+  if (res.hasValue()) {
+    return res.getValue();
+  }
+  return std::make_pair(std::numeric_limits<int64_t>::min(),
+                        std::numeric_limits<int64_t>::max());
+}
+
+void ClamRangeTable::write(const Module &M, raw_ostream &o) const {
+  if (m_table.empty()) {
+    return;
+  }
+  for (auto &F : M) {
+    write(F, o);
+  }
+}
+
+void ClamRangeTable::write(const Function &F, raw_ostream &o) const {
+  if (m_table.empty()) {
+    return;
+  }
+  unsigned id = 0;
+  auto writeValue = [this, &o, &F](const Value &v, unsigned id) {
+    llvm::Optional<Range> r = lookup(v);
+    if (r.hasValue()) {
+      o << F.getName() << " " << id << " " << r.getValue().first << " "
+        << r.getValue().second << "\n";
+    }
+  };
+  for (auto &Arg : F.args()) {
+    writeValue(Arg, id++);
+  }
+  for (auto &BB : F) {
+    for (auto &I : BB) {
+      writeValue(I, id++);
+    }
+  }
+}
+
+} // end namespace clam
@@ -16,6 +16,12 @@ cl::opt<bool> UseCrabNameValues(
     cl::desc("Use own crab way of naming values, otherwise LLVM instnamer"),
     cl::init(true));
 
+cl::opt<bool> SkipCrabNameValues(
+    "crab-skip-name-values",
+    cl::desc("Do not name values. Names of unnamed values are only "
+             "generated for printing"),
+    cl::init(false));
+
 namespace clam {
 
 char NameValues::ID = 0;
@@ -27,6 +33,10 @@ bool NameValues::runOnModule(Module &M) {
 }
 
 bool NameValues::runOnFunction(Function &F) {
+  if (SkipCrabNameValues) {
+    return false;
+  }
+
   if (UseCrabNameValues) {
     // -- print to string
     std::string funcAsm;
@@ -110,6 +120,13 @@ void NameValues::getAnalysisUsage(llvm::AnalysisUsage &AU) const {
   AU.setPreservesAll();
 }
 
+PreservedAnalyses NameValuesPass::run(Module &M, ModuleAnalysisManager &) {
+  NameValues nv;
+  nv.runOnModule(M);
+  // only names change
+  return PreservedAnalyses::all();
+}
+
 } // namespace clam
 
 static llvm::RegisterPass<clam::NameValues> Y("crab-name-values",
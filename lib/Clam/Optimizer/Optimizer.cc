@@ -1,32 +1,52 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/IR/ConstantRange.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/InstVisitor.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Transforms/Utils/UnifyFunctionExitNodes.h"
 
 #include "clam/config.h"
 #include "clam/CfgBuilder.hh"
 #include "clam/Clam.hh"
+#include "clam/ClamInvariants.hh"
+#include "clam/Support/Debug.hh"
 #include "clam/Transforms/Optimizer.hh"
 #include "crab/analysis/abs_transformer.hpp"
 
 #include "crab/config.h"
 #include "crab/support/debug.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 using namespace llvm;
 
@@ -59,6 +79,36 @@ llvm::cl::opt<bool>
 ReplaceWithConstants("crab-opt-replace-with-constants",
 	 llvm::cl::desc("Replace values with constants inferred by Crab"),
 	 llvm::cl::init(false));
+
+llvm::cl::opt<bool>
+AddRangeMetadata("crab-opt-add-range-metadata",
+	 llvm::cl::desc("Add !range/!nonnull metadata and nonnull attributes "
+			"to loads and calls using Crab invariants"),
+	 llvm::cl::init(false));
+llvm::cl::opt<bool>
+LowerChecks("crab-opt-lower-checks",
+	 llvm::cl::desc("Remove instrumented checks (e.g., --crab-null-check) "
+			"proven safe by Crab and lower the rest to runtime "
+			"checks that trap on failure. Use-after-free checks "
+			"are never lowered: the unproven ones are removed "
+			"with a warning"),
+	 llvm::cl::init(false));
+llvm::cl::opt<bool>
+NarrowIntegers("crab-opt-narrow-integers",
+	 llvm::cl::desc("Rewrite integer arithmetic to smaller integer types "
+			"using ranges inferred by Crab"),
+	 llvm::cl::init(false));
+llvm::cl::opt<bool>
+LoopTripCount("crab-opt-loop-trip-count",
+	 llvm::cl::desc("Bound the exit conditions of loops with the trip "
+			"counts inferred by Crab so that SCEV can use them, "
+			"assume the ranges of induction variables, and add "
+			"branch weights if the trip counts are exact"),
+	 llvm::cl::init(false));
+llvm::cl::opt<bool>
+FoldConditions("crab-opt-fold-conditions",
+	 llvm::cl::desc("Fold comparisons and switch cases using Crab invariants"),
+	 llvm::cl::init(false));
 /* End LLVM pass options */
 
 #define DEBUG_TYPE "crab-opt"
@@ -66,7 +116,21 @@ ReplaceWithConstants("crab-opt-replace-with-constants",
 STATISTIC(NumDeadBlocks, "Number of dead blocks");
 STATISTIC(NumDeadEdges, "Number of dead edges");
 STATISTIC(NumInstrBlocks, "Number of blocks instrumented with invariants");
+STATISTIC(NumRedundantCsts, "Number of invariant constraints implied by a dominator");
 STATISTIC(NumInstrLoads, "Number of load inst instrumented with invariants");
+STATISTIC(NumRangeMetadata, "Number of loads and calls with !range metadata");
+STATISTIC(NumNonNull, "Number of loads and calls marked as nonnull");
+STATISTIC(NumSafeChecks, "Number of instrumented checks proven safe");
+STATISTIC(NumRuntimeChecks, "Number of instrumented checks lowered to traps");
+STATISTIC(NumUnhardenedChecks, "Number of instrumented checks removed without runtime check");
+STATISTIC(NumNarrowedInsts, "Number of narrowed integer operations");
+STATISTIC(NumNarrowedBits, "Number of bits saved by integer narrowing");
+STATISTIC(NumNarrowedInductionCycles, "Number of narrowed induction cycles");
+STATISTIC(NumLoopTripCounts, "Number of loops with a maximum trip count");
+STATISTIC(NumExactLoopTripCounts, "Number of loops with an exact trip count");
+STATISTIC(NumClampedExitBounds, "Number of loop exit bounds clamped with a trip count");
+STATISTIC(NumFoldedCmps, "Number of comparisons folded using invariants");
+STATISTIC(NumFoldedCases, "Number of switch cases removed using invariants");
 
 namespace {
 
@@ -101,6 +165,12 @@ class CodeExpander {
 private:  
   enum bin_op_t { ADD, SUB, MUL };
 
+  // A linear expression without its constant: the variables and
+  // their coefficients.
+  using ExprKey = std::vector<std::pair<Value *, std::string>>;
+  // Code generated so far for each linear expression.
+  std::map<ExprKey, Value *> m_cache;
+
   Value *mkBinOp(bin_op_t Op, IRBuilder<> B, Value *LHS, Value *RHS,
 		 const Twine &Name) {
     assert(LHS->getType()->isIntegerTy() && RHS->getType()->isIntegerTy());
@@ -195,36 +265,76 @@ private:
       }
     }
 
+    // Normalize the sign of the expression so that, e.g., x-y <= 5
+    // and y-x <= 3 share the code of x-y.
     auto e = cst.expression() - cst.expression().constant();
-    Value *ee = mkNum(number_t("0"), ty, ctx);
+    bool negated = false;
+    for (auto t : e) {
+      if (t.first == 0)
+        continue;
+      negated = (t.first < number_t(0));
+      break;
+    }
+    ExprKey key;
     for (auto t : e) {
-      number_t n = t.first;
+      number_t n = (negated ? -t.first : t.first);
       if (n == 0)
         continue;
-      varname_t v = t.second.name();
-      Value *vv = mkVar(v);
-      assert(vv);
-      assert(vv->getType()->isIntegerTy());
-      if (n == 1) {
-        ee = mkBinOp(ADD, B, ee, vv, Name);
-      } else if (n == -1) {
-        ee = mkBinOp(SUB, B, ee, vv, Name);
-      } else {
-        ee = mkBinOp(ADD, B, ee,
-		     mkBinOp(MUL, B, mkNum(n, ty, ctx), vv, Name), Name);
+      key.push_back({mkVar(t.second.name()), n.get_str()});
+    }
+
+    Value *ee = lookup(key, B, DT);
+    if (!ee) {
+      for (auto t : e) {
+	number_t n = (negated ? -t.first : t.first);
+	if (n == 0)
+	  continue;
+	varname_t v = t.second.name();
+	Value *vv = mkVar(v);
+	assert(vv);
+	assert(vv->getType()->isIntegerTy());
+	if (n == 1) {
+	  ee = (ee ? mkBinOp(ADD, B, ee, vv, Name) : vv);
+	} else if (n == -1) {
+	  ee = mkBinOp(SUB, B, (ee ? ee : mkNum(number_t("0"), ty, ctx)), vv, Name);
+	} else {
+	  Value *term = mkBinOp(MUL, B, mkNum(n, ty, ctx), vv, Name);
+	  ee = (ee ? mkBinOp(ADD, B, ee, term, Name) : term);
+	}
+      }
+      if (!ee) {
+	ee = mkNum(number_t("0"), ty, ctx);
       }
+      m_cache[key] = ee;
     }
 
     number_t c = -cst.expression().constant();
-    Value *cc = mkNum(c, ty, ctx);
+    Value *cc = mkNum((negated ? -c : c), ty, ctx);
     if (cst.is_inequality()) {
-      return B.CreateICmpSLE(ee, cc, Name);
+      return (negated ? B.CreateICmpSGE(ee, cc, Name)
+	              : B.CreateICmpSLE(ee, cc, Name));
     } else if (cst.is_equality()) {
       return B.CreateICmpEQ(ee, cc, Name);
     } else {
       return B.CreateICmpNE(ee, cc, Name);
     }
   }
+
+  // Return the code already generated for key if it can be used at
+  // the insertion point of B. All the code of a block is generated at
+  // the same insertion point.
+  Value *lookup(const ExprKey &key, IRBuilder<> &B, DominatorTree *DT) {
+    auto it = m_cache.find(key);
+    if (it == m_cache.end()) {
+      return nullptr;
+    }
+    Instruction *I = dyn_cast<Instruction>(it->second);
+    if (!I || I->getParent() == B.GetInsertBlock() ||
+	(DT && DT->dominates(I, B.GetInsertBlock()))) {
+      return it->second;
+    }
+    return nullptr;
+  }
 public:
   /** Generate llvm bitcode from a set of linear constraints.
    *
@@ -237,12 +347,16 @@ public:
    **/
   bool genCode(lin_cst_sys_t csts, IRBuilder<> B, LLVMContext &ctx,
 	       Function *assumeFn, CallGraph *cg, DominatorTree *DT,
-	       const Function *insertFun, const Twine &Name = "") {
+	       const Function *insertFun, const Twine &Name = "",
+	       lin_cst_sys_t *emitted = nullptr) {
     bool change = false;
     for (auto cst : csts) {
       if (Value *cst_code = genCode(cst, B, ctx, DT, Name)) {
         CallInst *ci = B.CreateCall(assumeFn, cst_code);
         change = true;
+	if (emitted) {
+	  *emitted += cst;
+	}
         if (cg) {
           (*cg)[insertFun]->
 	    addCalledFunction(ci, (*cg)[ci->getCalledFunction()]);
@@ -254,6 +368,21 @@ public:
   
 };
 
+// Return true if cst holds in inv
+bool isImplied(const clam_abstract_domain &inv, const lin_cst_t &cst) {
+  if (cst.is_tautology()) {
+    return true;
+  }
+  if (cst.is_equality()) {
+    lin_exp_t zero(number_t(0));
+    return isImplied(inv, lin_cst_t(cst.expression() <= zero)) &&
+           isImplied(inv, lin_cst_t(cst.expression() >= zero));
+  }
+  clam_abstract_domain tmp(inv);
+  tmp += cst.negate();
+  return tmp.is_bottom();
+}
+
 // Generate bitcode for the value of v if it is a constant 
 Constant *getConstantInt(CfgBuilderPtr clamCfgBuilder, clam_abstract_domain inv, const Value &v) {
   if (v.getType()->isIntegerTy()) {
@@ -295,24 +424,16 @@ Constant *getConstantInt(CfgBuilderPtr clamCfgBuilder, clam_abstract_domain inv,
  */ 
 template<class Op>  
 bool GenericInstrumentStatement(clam_abstract_domain inv, basic_block_t &bb, Op op) {
-  // Forward propagation through the basic block but ignoring
-  // callsites. This might be imprecise if the analysis was
-  // inter-procedural because we cannot reconstruct all the context
-  // that the inter-procedural analysis had during the analysis.
-  using abs_tr_t = crab::analyzer::intra_abs_transformer<basic_block_t,
-                                                         clam_abstract_domain>;
-  abs_tr_t vis(inv);
   bool change = false;
-  for (auto &s : bb) {
-    s.accept(&vis); // propagate the invariant one statement forward
-    const clam_abstract_domain &next_inv = vis.get_abs_value();
-    if (next_inv.is_top())
-      continue;
-    if (op.Skip(s))
-      continue;
+  forEachStmtPost(bb, inv, [&](const statement_t &s,
+                               clam_abstract_domain &next_inv) {
+    if (next_inv.is_top() || op.Skip(s)) {
+      return true;
+    }
     op.Process(s, next_inv);
     change = true;
-  }
+    return true;
+  });
   return change;
 }
 
@@ -354,6 +475,36 @@ Instruction* getLoadInst(const statement_t &s) {
   return nullptr;
 }
   
+// Insert after LI an assume for each constraint of inv that mentions
+// some variable of rel_vars.
+void instrumentLoad(IRBuilder<> &IB, Instruction *LI,
+                    const std::set<var_t> &rel_vars,
+                    const clam_abstract_domain &inv, Function *assumeFn,
+                    CallGraph *cg) {
+  // Filter out all irrelevant constraints
+  lin_cst_sys_t rel_csts;
+  for (auto cst : inv.to_linear_constraint_system()) {
+    std::vector<var_t> v_intersect;
+    std::set_intersection(cst.variables().begin(), cst.variables().end(),
+                          rel_vars.begin(), rel_vars.end(),
+                          std::back_inserter(v_intersect));
+    if (!v_intersect.empty()) {
+      rel_csts += cst;
+    }
+  }
+
+  // Insert an assume instruction after the load instruction (LI)
+  IB.SetInsertPoint(LI);
+  llvm::BasicBlock *InsertBlk = IB.GetInsertBlock();
+  llvm::BasicBlock::iterator InsertPt = IB.GetInsertPoint();
+  InsertPt++; // this is ok because LoadInstr cannot be terminators.
+  IB.SetInsertPoint(InsertBlk, InsertPt);
+  NumInstrLoads++;
+  CodeExpander g;
+  g.genCode(rel_csts, IB, IB.getContext(), assumeFn, cg, nullptr,
+            LI->getParent()->getParent(), "crab_");
+}
+
 class InstrumentLoadStmt {
   IRBuilder<> &m_IB;
   Instruction  *m_LI;
@@ -370,32 +521,9 @@ public:
   
   void Process(const statement_t &s, const clam_abstract_domain &inv) {
     if (!m_LI) return; 
-    
-    // Filter out all irrelevant constraints
-    lin_cst_sys_t rel_csts;
-    std::set<var_t> rel_vars;
-    rel_vars.insert(s.get_live().defs_begin(), s.get_live().defs_end());
-    for (auto cst : inv.to_linear_constraint_system()) {
-      std::vector<var_t> v_intersect;
-      std::set_intersection(cst.variables().begin(), cst.variables().end(),
-                            rel_vars.begin(), rel_vars.end(),
-                            std::back_inserter(v_intersect));
-      if (!v_intersect.empty()) {
-        rel_csts += cst;
-      }
-    }
-
-    // Insert an assume instruction after the load instruction (m_LI)
-    m_IB.SetInsertPoint(m_LI);
-    llvm::BasicBlock *InsertBlk = m_IB.GetInsertBlock();
-    llvm::BasicBlock::iterator InsertPt = m_IB.GetInsertPoint();
-    InsertPt++; // this is ok because LoadInstr cannot be terminators.
-    m_IB.SetInsertPoint(InsertBlk, InsertPt);
-    NumInstrLoads++;
-    CodeExpander g;    
-    g.genCode(rel_csts, m_IB, m_IB.getContext(), m_assumeFn, m_cg, nullptr,
-	      m_LI->getParent()->getParent(), "crab_");
-
+    std::set<var_t> rel_vars(s.get_live().defs_begin(),
+                             s.get_live().defs_end());
+    instrumentLoad(m_IB, m_LI, rel_vars, inv, m_assumeFn, m_cg);
     // reset internal state
     m_LI = nullptr;
   }
@@ -432,29 +560,475 @@ public:
   }
 };
   
+// Return !range metadata for the integer value v from its interval in
+// inv. Return nullptr if the interval does not fit in v's type (as a
+// signed integer) or it is the full range of the type.
+MDNode *getRangeMetadata(CfgBuilderPtr clamCfgBuilder,
+			 const clam_abstract_domain &inv, const Value &v) {
+  IntegerType *ty = dyn_cast<IntegerType>(v.getType());
+  // Booleans are not modeled as integers by Crab
+  if (!ty || ty->getBitWidth() <= 1 || ty->getBitWidth() > 64) {
+    return nullptr;
+  }
+  llvm::Optional<var_t> crabVar = clamCfgBuilder->getCrabVariable(v);
+  if (!crabVar.hasValue()) {
+    return nullptr;
+  }
+  clam_abstract_domain tmp(inv);
+  llvm::Optional<ClamQueryAPI::Range> r = getInt64Range(tmp, crabVar.getValue());
+  if (!r.hasValue()) {
+    return nullptr;
+  }
+  unsigned bitwidth = ty->getBitWidth();
+  int64_t lb = r.getValue().first;
+  int64_t ub = r.getValue().second;
+  int64_t typeMin = APInt::getSignedMinValue(bitwidth).getSExtValue();
+  int64_t typeMax = APInt::getSignedMaxValue(bitwidth).getSExtValue();
+  if (lb < typeMin || ub > typeMax || (lb == typeMin && ub == typeMax)) {
+    return nullptr;
+  }
+  // LLVM ranges are half-open: [lb, ub+1)
+  APInt lo(bitwidth, lb, true);
+  APInt hi(bitwidth, ub, true);
+  ++hi;
+  MDBuilder MDB(v.getContext());
+  return MDB.createRange(lo, hi);
+}
+
+// Return true if the reference v cannot be null in inv.
+bool isNonNull(CfgBuilderPtr clamCfgBuilder, const clam_abstract_domain &inv,
+	       const Value &v) {
+  if (!v.getType()->isPointerTy()) {
+    return false;
+  }
+  llvm::Optional<var_t> crabRef = clamCfgBuilder->getCrabVariable(v);
+  if (!crabRef.hasValue() || !crabRef.getValue().get_type().is_reference()) {
+    return false;
+  }
+  clam_abstract_domain tmp(inv);
+  if (tmp.is_bottom()) {
+    return false;
+  }
+  tmp.ref_assume(ref_cst_t::mk_null(crabRef.getValue()));
+  return tmp.is_bottom();
+}
+
+// Attach !range (integers) or !nonnull (pointers) metadata to loads.
+class RangeMetadataStmt {
+  CfgBuilderPtr m_clamCfgBuilder;
+  LoadInst *m_LI;
+  // only the first statement that defines a LoadInst is relevant
+  DenseSet<const LoadInst *> m_seen;
+public:
+  RangeMetadataStmt(CfgBuilderPtr clamCfgBuilder)
+    : m_clamCfgBuilder(clamCfgBuilder), m_LI(nullptr) {}
+
+  bool Skip(const statement_t &s) {
+    m_LI = nullptr;
+    if (s.get_live().num_defs() != 1) {
+      return true;
+    }
+    if (auto v = (*(s.get_live().defs_begin())).name().get()) {
+      if (auto LI = dyn_cast<const LoadInst>(*v)) {
+	if (m_seen.insert(LI).second) {
+	  m_LI = const_cast<LoadInst *>(LI);
+	}
+      }
+    }
+    return !m_LI;
+  }
+
+  void Process(const statement_t &s, const clam_abstract_domain &inv) {
+    if (!m_LI || inv.is_bottom()) return;
+    LLVMContext &ctx = m_LI->getContext();
+    if (m_LI->getType()->isIntegerTy()) {
+      if (!m_LI->getMetadata(LLVMContext::MD_range)) {
+	if (MDNode *range = getRangeMetadata(m_clamCfgBuilder, inv, *m_LI)) {
+	  m_LI->setMetadata(LLVMContext::MD_range, range);
+	  NumRangeMetadata++;
+	}
+      }
+    } else if (m_LI->getType()->isPointerTy()) {
+      if (!m_LI->getMetadata(LLVMContext::MD_nonnull) &&
+	  isNonNull(m_clamCfgBuilder, inv, *m_LI)) {
+	m_LI->setMetadata(LLVMContext::MD_nonnull, MDNode::get(ctx, None));
+	NumNonNull++;
+      }
+    }
+    m_LI = nullptr;
+  }
+};
+  
+// Return true if I is a check added by an instrumentation pass
+bool isInstrumentedCheck(const Instruction &I) {
+  return isa<CallInst>(I) && I.getMetadata("clam-assertion");
+}
+
+// Return true if the assertion s holds in inv (the invariant that
+// holds before s). The negation of the assertion is added to inv and
+// the assertion holds if the result is bottom.
+bool isProvenSafe(const statement_t &s, clam_abstract_domain inv,
+		  const Instruction &check) {
+  using assert_t =
+    assert_stmt<basic_block_label_t, number_t, varname_t>;
+  using bool_assert_t =
+    bool_assert_stmt<basic_block_label_t, number_t, varname_t>;
+  
+  if (inv.is_bottom()) {
+    // unreachable
+    return true;
+  }
+  if (s.is_assert()) {
+    const assert_t *assert_stmt = static_cast<const assert_t *>(&s);
+    lin_cst_t cst = assert_stmt->constraint();
+    if (cst.is_tautology()) {
+      return true;
+    }
+    if (cst.is_contradiction()) {
+      return false;
+    }
+    inv += cst.negate();
+    return inv.is_bottom();
+  } else if (s.is_bool_assert()) {
+    const bool_assert_t *assert_stmt = static_cast<const bool_assert_t *>(&s);
+    const bool is_negated = true;
+    inv.assume_bool(assert_stmt->cond(), is_negated);
+    return inv.is_bottom();
+  } else if (s.is_ref_assert()) {
+    // The only reference assertions generated by Clam come from
+    // comparisons of a pointer with null (e.g., --crab-null-check)
+    const CallInst &CI = cast<CallInst>(check);
+    const Value *cond = CI.getArgOperand(0);
+    if (const CastInst *CastI = dyn_cast<CastInst>(cond)) {
+      cond = CastI->getOperand(0);
+    }
+    const ICmpInst *CmpI = dyn_cast<ICmpInst>(cond);
+    if (!CmpI || CmpI->getPredicate() != ICmpInst::ICMP_NE) {
+      return false;
+    }
+    const Value *ptr = CmpI->getOperand(0);
+    if (!isa<ConstantPointerNull>(CmpI->getOperand(1))) {
+      if (!isa<ConstantPointerNull>(ptr)) {
+	return false;
+      }
+      ptr = CmpI->getOperand(1);
+    }
+    llvm::Optional<var_t> crabRef = llvm::None;
+    for (auto it = s.get_live().uses_begin(), et = s.get_live().uses_end();
+	 it != et; ++it) {
+      if ((*it).name().get() && *((*it).name().get()) == ptr) {
+	crabRef = *it;
+      }
+    }
+    if (!crabRef.hasValue()) {
+      return false;
+    }
+    inv.ref_assume(ref_cst_t::mk_null(crabRef.getValue()));
+    return inv.is_bottom();
+  }
+  return false;
+}
+
+// Collect the instrumented checks of a basic block and whether they
+// are proven safe.
+class CollectChecks {
+  CfgBuilderPtr m_clamCfgBuilder;
+  std::vector<std::pair<WeakVH, bool>> &m_checks;
+  
+public:
+  CollectChecks(CfgBuilderPtr clamCfgBuilder,
+		std::vector<std::pair<WeakVH, bool>> &checks)
+    : m_clamCfgBuilder(clamCfgBuilder), m_checks(checks) {}
+
+  void run(clam_abstract_domain inv, basic_block_t &bb) {
+    // The assertion is checked on the invariant that holds before
+    // the statement.
+    forEachStmtPre(bb, inv, [this](const statement_t &s,
+				   clam_abstract_domain &pre) {
+      if (s.is_assert() || s.is_bool_assert() || s.is_ref_assert()) {
+	if (const Instruction *I = m_clamCfgBuilder->getInstruction(s)) {
+	  if (isInstrumentedCheck(*I)) {
+	    bool isSafe = isProvenSafe(s, pre, *I);
+	    m_checks.push_back({WeakVH(const_cast<Instruction *>(I)), isSafe});
+	  }
+	}
+      }
+      return true;
+    });
+  }
+};
+  
+// Return the smallest bitwidth (8, 16 or 32) smaller than the
+// bitwidth of v that can represent all the values of v in inv as
+// signed integers. Return 0 if there is none.
+unsigned getNarrowBitwidth(CfgBuilderPtr clamCfgBuilder,
+			   const clam_abstract_domain &inv, const Value &v) {
+  IntegerType *ty = dyn_cast<IntegerType>(v.getType());
+  if (!ty || ty->getBitWidth() > 64) {
+    return 0;
+  }
+  int64_t lb, ub;
+  if (const ConstantInt *CI = dyn_cast<ConstantInt>(&v)) {
+    lb = ub = CI->getSExtValue();
+  } else {
+    llvm::Optional<var_t> crabVar = clamCfgBuilder->getCrabVariable(v);
+    if (!crabVar.hasValue() || !crabVar.getValue().get_type().is_integer()) {
+      return 0;
+    }
+    clam_abstract_domain tmp(inv);
+    llvm::Optional<ClamQueryAPI::Range> r =
+      getInt64Range(tmp, crabVar.getValue());
+    if (!r.hasValue()) {
+      return 0;
+    }
+    lb = r.getValue().first;
+    ub = r.getValue().second;
+  }
+  for (unsigned bitwidth : {8, 16, 32}) {
+    if (bitwidth >= ty->getBitWidth()) {
+      break;
+    }
+    if (lb >= APInt::getSignedMinValue(bitwidth).getSExtValue() &&
+	ub <= APInt::getSignedMaxValue(bitwidth).getSExtValue()) {
+      return bitwidth;
+    }
+  }
+  return 0;
+}
+
+bool isNarrowableOp(const Instruction &I) {
+  switch (I.getOpcode()) {
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::Mul:
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+    return I.getType()->isIntegerTy();
+  default:
+    return false;
+  }
+}
+
+// Decide which binary operations can be computed in a smaller
+// type. An operation can be narrowed if its result and operands fit
+// in the smaller type as signed integers. Then, computing modulo the
+// smaller type and sign-extending the result gives the same value.
+class NarrowIntegerStmt {
+  CfgBuilderPtr m_clamCfgBuilder;
+  BinaryOperator *m_BO;
+  // only the first statement that defines an instruction is relevant
+  DenseSet<const BinaryOperator *> m_seen;
+  std::vector<std::pair<BinaryOperator *, unsigned>> &m_narrowed;
+public:
+  NarrowIntegerStmt(CfgBuilderPtr clamCfgBuilder,
+		    std::vector<std::pair<BinaryOperator *, unsigned>> &narrowed)
+    : m_clamCfgBuilder(clamCfgBuilder), m_BO(nullptr), m_narrowed(narrowed) {}
+
+  bool Skip(const statement_t &s) {
+    m_BO = nullptr;
+    if (s.get_live().num_defs() != 1) {
+      return true;
+    }
+    if (auto v = (*(s.get_live().defs_begin())).name().get()) {
+      if (auto BO = dyn_cast<const BinaryOperator>(*v)) {
+	if (isNarrowableOp(*BO) && m_seen.insert(BO).second) {
+	  m_BO = const_cast<BinaryOperator *>(BO);
+	}
+      }
+    }
+    return !m_BO;
+  }
+
+  void Process(const statement_t &s, const clam_abstract_domain &inv) {
+    if (!m_BO || inv.is_bottom()) return;
+    unsigned bitwidth = 0;
+    const Value *values[] = {m_BO, m_BO->getOperand(0), m_BO->getOperand(1)};
+    for (const Value *v : values) {
+      unsigned vBitwidth = getNarrowBitwidth(m_clamCfgBuilder, inv, *v);
+      if (vBitwidth == 0) {
+	m_BO = nullptr;
+	return;
+      }
+      bitwidth = std::max(bitwidth, vBitwidth);
+    }
+    m_narrowed.push_back({m_BO, bitwidth});
+    m_BO = nullptr;
+  }
+};
+  
+// Convert the signed interval [lb, ub] to a ConstantRange of the
+// given bitwidth. It is the full set if the interval does not fit.
+ConstantRange toConstantRange(unsigned bitwidth, int64_t lb, int64_t ub) {
+  if (bitwidth == 1 || bitwidth > 64) {
+    return ConstantRange(bitwidth, true /*full set*/);
+  }
+  int64_t smin = APInt::getSignedMinValue(bitwidth).getSExtValue();
+  int64_t smax = APInt::getSignedMaxValue(bitwidth).getSExtValue();
+  if (lb > ub || lb < smin || ub > smax || (lb == smin && ub == smax)) {
+    return ConstantRange(bitwidth, true /*full set*/);
+  }
+  return ConstantRange(APInt(bitwidth, lb, true), APInt(bitwidth, ub, true) + 1);
+}
+
+// Return the values that the integer v can take in B. The range of
+// an SSA value where it is defined (or at the entry of B if it is
+// defined elsewhere) holds at any later point of B.
+ConstantRange getConstantRange(ClamQueryAPI &clam, const BasicBlock &B,
+			       const Value &v) {
+  if (const ConstantInt *CI = dyn_cast<ConstantInt>(&v)) {
+    return ConstantRange(CI->getValue());
+  }
+  ClamQueryAPI::Range r;
+  const Instruction *I = dyn_cast<Instruction>(&v);
+  if (I && I->getParent() == &B && !isa<PHINode>(I)) {
+    r = clam.range(*I);
+  } else {
+    r = clam.range(B, v);
+  }
+  return toConstantRange(v.getType()->getIntegerBitWidth(), r.first, r.second);
+}
+
+// Return the values that the integer v can take in inv.
+ConstantRange getConstantRange(CfgBuilderPtr clamCfgBuilder,
+			       const clam_abstract_domain &inv, const Value &v) {
+  unsigned bitwidth = v.getType()->getIntegerBitWidth();
+  if (const ConstantInt *CI = dyn_cast<ConstantInt>(&v)) {
+    return ConstantRange(CI->getValue());
+  }
+  llvm::Optional<var_t> crabVar = clamCfgBuilder->getCrabVariable(v);
+  if (!crabVar.hasValue() || !crabVar.getValue().get_type().is_integer()) {
+    return ConstantRange(bitwidth, true /*full set*/);
+  }
+  clam_abstract_domain tmp(inv);
+  llvm::Optional<ClamQueryAPI::Range> r = getInt64Range(tmp, crabVar.getValue());
+  if (!r.hasValue()) {
+    return ConstantRange(bitwidth, true /*full set*/);
+  }
+  return toConstantRange(bitwidth, r.getValue().first, r.getValue().second);
+}
+  
+// Return the value of the comparison I if it is the same for all
+// values of its operands in lhs and rhs. Otherwise, return nullptr.
+Constant *foldICmp(const ICmpInst &I, const ConstantRange &lhs,
+		   const ConstantRange &rhs) {
+  if (lhs.isFullSet() && rhs.isFullSet()) {
+    return nullptr;
+  }
+  if (ConstantRange::makeSatisfyingICmpRegion(I.getPredicate(), rhs)
+      .contains(lhs)) {
+    return ConstantInt::getTrue(I.getType());
+  }
+  if (ConstantRange::makeSatisfyingICmpRegion(I.getInversePredicate(), rhs)
+      .contains(lhs)) {
+    return ConstantInt::getFalse(I.getType());
+  }
+  return nullptr;
+}
+  
 } // end namespace 
 
 namespace clam {
   
-// Instrument basic block entries with a sequence of assume instructions
+// Instrument basic block entries with a sequence of assume
+// instructions. The constraints that have been instrumented are
+// added to emitted.
 static bool instrumentBlock(lin_cst_sys_t csts, llvm::BasicBlock *bb,
-			    LLVMContext &ctx, CallGraph *cg, DominatorTree *DT,
-			    Function *assumeFn) {
+			    CodeExpander &g, CallGraph *cg, DominatorTree *DT,
+			    Function *assumeFn, lin_cst_sys_t &emitted) {
 
   // If the block is an exit we do not instrument it.
   const ReturnInst *ret = dyn_cast<const ReturnInst>(bb->getTerminator());
   if (ret)
     return false;
 
+  LLVMContext &ctx = bb->getContext();
   IRBuilder<> Builder(ctx);
   Builder.SetInsertPoint(bb->getFirstNonPHI());
-  CodeExpander g;
   NumInstrBlocks++;
   bool res = g.genCode(csts, Builder, ctx, assumeFn, cg, DT, bb->getParent(),
-                        "crab_");
+                        "crab_", &emitted);
   return res;
 }
 
+// Instrument the entries of the blocks of F with their invariants.
+// If the dominator tree is available then blocks are visited in
+// dominator tree order, constraints implied by the ones already
+// assumed at a dominator are skipped, and the code of a linear
+// expression is shared with the dominated blocks.
+bool Optimizer::instrumentBlocks(Function &F, DominatorTree *dt) {
+  LoopInfo *LI = nullptr;
+  if (m_invLoc == InvariantsLocation::LOOP_HEADER) {
+    LI = m_li(&F); // it can be nullptr
+    if (!LI) {
+      return false;
+    }
+  }
+
+  std::vector<BasicBlock *> blocks;
+  if (dt) {
+    for (DomTreeNode *N : depth_first(dt->getRootNode())) {
+      blocks.push_back(N->getBlock());
+    }
+  } else {
+    for (auto &B : F) {
+      blocks.push_back(&B);
+    }
+  }
+
+  // Constraints assumed at the entry of each instrumented block
+  // (including the ones assumed at its dominators).
+  std::unordered_map<const BasicBlock *, clam_abstract_domain> assumed;
+  CodeExpander g;
+  bool change = false;
+  for (BasicBlock *B : blocks) {
+    if (hasUnreachable(*B)) {
+      continue;
+    }
+    if (LI && !LI->isLoopHeader(B)) {
+      continue;
+    }
+    const bool keep_ghost = false;
+    llvm::Optional<clam_abstract_domain> pre = m_clam.getPre(B, keep_ghost);
+    if (!pre.hasValue()) {
+      continue;
+    }
+    if (m_removeDeadCode && pre.getValue().is_bottom()) {
+      // the block will be removed
+      continue;
+    }
+
+    const clam_abstract_domain *dominating = nullptr;
+    if (dt) {
+      for (DomTreeNode *N = dt->getNode(B)->getIDom(); N && !dominating;
+	   N = N->getIDom()) {
+	auto it = assumed.find(N->getBlock());
+	if (it != assumed.end()) {
+	  dominating = &(it->second);
+	}
+      }
+    }
+
+    lin_cst_sys_t csts;
+    for (auto cst : pre.getValue().to_linear_constraint_system()) {
+      if (dominating && isImplied(*dominating, cst)) {
+	NumRedundantCsts++;
+	continue;
+      }
+      csts += cst;
+    }
+    lin_cst_sys_t emitted;
+    change |= instrumentBlock(csts, B, g, m_cg, dt, m_assumeFn, emitted);
+    if (dt && emitted.begin() != emitted.end()) {
+      clam_abstract_domain inv =
+	(dominating ? *dominating : pre.getValue().make_top());
+      inv += emitted;
+      assumed.insert({B, inv});
+    }
+  }
+  return change;
+}
+
 // Instrument LoadInst with a sequence of assume instructions  
 static bool instrumentLoadInst(clam_abstract_domain inv, basic_block_t &bb,
 			       LLVMContext &ctx, CallGraph *cg,
@@ -464,6 +1038,45 @@ static bool instrumentLoadInst(clam_abstract_domain inv, basic_block_t &bb,
   return GenericInstrumentStatement(inv, bb, ILS);
 }
 
+// Instrument the LoadInst of B using the invariants stored after each
+// of them by the analysis. Return None without changing B if some
+// load has no stored invariants.
+static llvm::Optional<bool>
+instrumentLoadInstFromStored(ClamGlobalAnalysis &clam, BasicBlock &B,
+                             CfgBuilderPtr clamCfgBuilder, CallGraph *cg,
+                             Function *assumeFn) {
+  const bool keep_ghost = true;
+  std::vector<std::pair<LoadInst *, clam_abstract_domain>> loads;
+  for (auto &I : B) {
+    if (LoadInst *LI = dyn_cast<LoadInst>(&I)) {
+      llvm::Optional<var_t> v = clamCfgBuilder->getCrabVariable(*LI);
+      if (!v.hasValue()) {
+        // the load is not translated to Crab
+        continue;
+      }
+      llvm::Optional<clam_abstract_domain> inv =
+        clam.getPostStmt(LI, keep_ghost);
+      if (!inv.hasValue()) {
+        return llvm::None;
+      }
+      loads.push_back({LI, inv.getValue()});
+    }
+  }
+
+  IRBuilder<> Builder(B.getContext());
+  bool change = false;
+  for (auto &kv : loads) {
+    if (kv.second.is_bottom()) {
+      continue;
+    }
+    std::set<var_t> rel_vars;
+    rel_vars.insert(clamCfgBuilder->getCrabVariable(*kv.first).getValue());
+    instrumentLoad(Builder, kv.first, rel_vars, kv.second, assumeFn, cg);
+    change = true;
+  }
+  return change;
+}
+
 // Do constant replacement  
 static bool constantReplacement(CfgBuilderPtr clamCfgBuilder,
 				clam_abstract_domain inv,
@@ -472,6 +1085,767 @@ static bool constantReplacement(CfgBuilderPtr clamCfgBuilder,
   return GenericInstrumentStatement(inv, bb, CRS);
 }
 
+// Add !range and !nonnull metadata to the loads of bb
+static bool addLoadRangeMetadata(CfgBuilderPtr clamCfgBuilder,
+				 clam_abstract_domain inv,
+				 basic_block_t &bb) {
+  RangeMetadataStmt RMS(clamCfgBuilder);
+  return GenericInstrumentStatement(inv, bb, RMS);
+}
+
+// Return the facts that hold on the value returned by F. They are
+// taken from the invariants at the exit of F so they hold for all the
+// (analyzed) callsites of F.
+static ReturnFacts getReturnFacts(ClamGlobalAnalysis &clam,
+				  const Function &F) {
+  ReturnFacts facts = {nullptr, false};
+  if (F.empty() || F.isVarArg() || !clam.getCfgBuilderMan().hasCfg(F)) {
+    return facts;
+  }
+  const ReturnInst *ret = nullptr;
+  for (auto &B : F) {
+    if (auto RI = dyn_cast<const ReturnInst>(B.getTerminator())) {
+      if (ret) {
+	// Clam requires UnifyFunctionExitNodes
+	return facts;
+      }
+      ret = RI;
+    }
+  }
+  if (!ret || !ret->getReturnValue()) {
+    return facts;
+  }
+  const Value &retVal = *(ret->getReturnValue());
+  const bool keep_ghost = false;
+  llvm::Optional<clam_abstract_domain> post =
+    clam.getPost(ret->getParent(), keep_ghost);
+  if (!post.hasValue() || post.getValue().is_bottom()) {
+    return facts;
+  }
+  auto cfg_builder_ptr = clam.getCfgBuilderMan().getCfgBuilder(F);
+  facts.range = getRangeMetadata(cfg_builder_ptr, post.getValue(), retVal);
+  facts.nonnull = isNonNull(cfg_builder_ptr, post.getValue(), retVal);
+  return facts;
+}
+
+// Add !range metadata and nonnull attributes to the direct calls of B
+bool Optimizer::addCallRangeMetadata(BasicBlock &B) {
+  bool change = false;
+  for (auto &I : B) {
+    CallInst *CI = dyn_cast<CallInst>(&I);
+    if (!CI) continue;
+    const Function *callee = CI->getCalledFunction();
+    if (!callee || callee->isDeclaration()) continue;
+    auto it = m_retFacts.find(callee);
+    if (it == m_retFacts.end()) {
+      it = m_retFacts.insert({callee, getReturnFacts(m_clam, *callee)}).first;
+    }
+    const ReturnFacts &facts = it->second;
+    if (facts.range && CI->getType()->isIntegerTy() &&
+	!CI->getMetadata(LLVMContext::MD_range)) {
+      CI->setMetadata(LLVMContext::MD_range, facts.range);
+      NumRangeMetadata++;
+      change = true;
+    } else if (facts.nonnull && CI->getType()->isPointerTy() &&
+	       !CI->hasRetAttr(Attribute::NonNull)) {
+      CI->addAttribute(AttributeList::ReturnIndex, Attribute::NonNull);
+      NumNonNull++;
+      change = true;
+    }
+  }
+  return change;
+}
+
+// Replace the instrumented check CI with a branch to a block that
+// calls llvm.trap if the check fails.
+static void lowerCheckToTrap(CallInst *CI, Function *trapFn, CallGraph *cg) {
+  LLVMContext &ctx = CI->getContext();
+  Value *cond = CI->getArgOperand(0);
+  IRBuilder<> Builder(CI);
+  Value *failed = Builder.CreateICmpEQ(
+      cond, Constant::getNullValue(cond->getType()), "crab_check_failed");
+  MDNode *weights = MDBuilder(ctx).createBranchWeights(1, (1U << 20) - 1);
+  Instruction *unreach =
+    SplitBlockAndInsertIfThen(failed, CI, true /*unreachable*/, weights);
+  Builder.SetInsertPoint(unreach);
+  CallInst *trap = Builder.CreateCall(trapFn);
+  trap->setDebugLoc(CI->getDebugLoc());
+  if (cg) {
+    CallGraphNode *cgn = (*cg)[CI->getFunction()];
+    cgn->removeCallEdgeFor(*CI);
+    cgn->addCalledFunction(trap, cg->getOrInsertFunction(trapFn));
+  }
+  CI->eraseFromParent();
+}
+
+// Erase v and the instructions used only by v if they are dead. The
+// Crab intrinsics (e.g., __CRAB_intrinsic_is_unfreed_or_null) are
+// readnone but not nounwind so LLVM does not consider them trivially
+// dead. They have no definition so they must be removed.
+static void deleteDeadCondition(Value *v, CallGraph *cg) {
+  SmallSetVector<Instruction *, 8> worklist;
+  if (Instruction *I = dyn_cast<Instruction>(v)) {
+    worklist.insert(I);
+  }
+  while (!worklist.empty()) {
+    Instruction *I = worklist.pop_back_val();
+    if (!I->use_empty()) {
+      continue;
+    }
+    CallInst *CI = dyn_cast<CallInst>(I);
+    Function *callee = (CI ? CI->getCalledFunction() : nullptr);
+    bool isCrabIntrinsic =
+      callee && callee->getName().startswith("__CRAB_intrinsic_");
+    if (!isCrabIntrinsic && !isInstructionTriviallyDead(I)) {
+      continue;
+    }
+    if (isCrabIntrinsic && cg) {
+      (*cg)[CI->getFunction()]->removeCallEdgeFor(*CI);
+    }
+    for (Use &op : I->operands()) {
+      if (Instruction *opI = dyn_cast<Instruction>(op.get())) {
+	worklist.insert(opI);
+      }
+    }
+    I->eraseFromParent();
+  }
+}
+
+// Remove the instrumented check CI and its condition if it becomes
+// dead.
+static void removeCheck(CallInst *CI, CallGraph *cg) {
+  Value *cond = CI->getArgOperand(0);
+  if (cg) {
+    (*cg)[CI->getFunction()]->removeCallEdgeFor(*CI);
+  }
+  CI->eraseFromParent();
+  deleteDeadCondition(cond, cg);
+}
+
+// Return true if the condition of the instrumented check CI can only
+// be evaluated by Crab (e.g., __CRAB_intrinsic_is_unfreed_or_null)
+// and therefore it cannot be lowered to a runtime check.
+static bool hasCrabOnlyCondition(const CallInst &CI) {
+  const Value *cond = CI.getArgOperand(0)->stripPointerCasts();
+  if (const CastInst *Cast = dyn_cast<CastInst>(cond)) {
+    cond = Cast->getOperand(0);
+  }
+  if (const CallInst *condCI = dyn_cast<CallInst>(cond)) {
+    const Function *callee = condCI->getCalledFunction();
+    return (callee && callee->getName().startswith("__CRAB_intrinsic_"));
+  }
+  return false;
+}
+
+// Decide which operations of bb can be narrowed
+static bool markNarrowIntegers(CfgBuilderPtr clamCfgBuilder,
+			       clam_abstract_domain inv, basic_block_t &bb,
+			       std::vector<std::pair<BinaryOperator *, unsigned>> &narrowed) {
+  NarrowIntegerStmt NIS(clamCfgBuilder, narrowed);
+  return GenericInstrumentStatement(inv, bb, NIS);
+}
+
+// Rewrite each operation in narrowed to its new bitwidth. The narrow
+// result is sign-extended for the existing users but other narrowed
+// operations use the narrow value directly.
+static void narrowIntegers(Function &F,
+			   std::vector<std::pair<BinaryOperator *, unsigned>> &narrowed) {
+  if (narrowed.empty()) {
+    return;
+  }
+  LLVMContext &ctx = F.getContext();
+  DenseMap<const Instruction *, unsigned> bitwidths(narrowed.begin(),
+						    narrowed.end());
+  DenseMap<const Value *, Value *> narrowValues;
+  std::vector<BinaryOperator *> rewritten;
+  // Operands are rewritten before their uses
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  for (BasicBlock *B : RPOT) {
+    for (Instruction &I : *B) {
+      auto it = bitwidths.find(&I);
+      if (it == bitwidths.end()) {
+	continue;
+      }
+      BinaryOperator *BO = cast<BinaryOperator>(&I);
+      IntegerType *narrowTy = IntegerType::get(ctx, it->second);
+      IRBuilder<> Builder(BO);
+      auto getNarrowOperand = [&Builder, &narrowValues, narrowTy](Value *op) {
+	auto nit = narrowValues.find(op);
+	if (nit != narrowValues.end()) {
+	  return Builder.CreateSExtOrTrunc(nit->second, narrowTy);
+	}
+	return Builder.CreateTrunc(op, narrowTy);
+      };
+      Value *op0 = getNarrowOperand(BO->getOperand(0));
+      Value *op1 = getNarrowOperand(BO->getOperand(1));
+      Value *narrowBO = Builder.CreateBinOp(BO->getOpcode(), op0, op1,
+					    BO->getName() + ".narrow");
+      Value *wideBO = Builder.CreateSExt(narrowBO, BO->getType());
+      BO->replaceAllUsesWith(wideBO);
+      // users of BO now use wideBO
+      narrowValues[wideBO] = narrowBO;
+      rewritten.push_back(BO);
+      NumNarrowedInsts++;
+      NumNarrowedBits += BO->getType()->getIntegerBitWidth() - it->second;
+    }
+  }
+  for (BinaryOperator *BO : rewritten) {
+    BO->eraseFromParent();
+  }
+  CRAB_VERBOSE_IF(1, crab::get_msg_stream()
+		  << "Narrowed " << rewritten.size() << " integer operations in "
+		  << F.getName().str() << ".\n";);
+}
+
+// Return the increment of the induction variable PHI (a header phi
+// incremented by a non-zero constant Step in the latch) or nullptr.
+static BinaryOperator *getInductionIncrement(PHINode &PHI, BasicBlock *latch,
+					     ConstantInt *&Step) {
+  Step = nullptr;
+  int latchIdx = PHI.getBasicBlockIndex(latch);
+  if (latchIdx < 0) {
+    return nullptr;
+  }
+  BinaryOperator *Inc = dyn_cast<BinaryOperator>(PHI.getIncomingValue(latchIdx));
+  if (!Inc) {
+    return nullptr;
+  }
+  if (Inc->getOpcode() == Instruction::Add) {
+    if (Inc->getOperand(0) == &PHI) {
+      Step = dyn_cast<ConstantInt>(Inc->getOperand(1));
+    } else if (Inc->getOperand(1) == &PHI) {
+      Step = dyn_cast<ConstantInt>(Inc->getOperand(0));
+    }
+  } else if (Inc->getOpcode() == Instruction::Sub &&
+	     Inc->getOperand(0) == &PHI) {
+    Step = dyn_cast<ConstantInt>(Inc->getOperand(1));
+  }
+  if (!Step || Step->isZero() || Step->getBitWidth() > 64) {
+    Step = nullptr;
+    return nullptr;
+  }
+  return Inc;
+}
+
+// Return the smallest bitwidth (8, 16 or 32) smaller than bitwidth
+// that can represent all the values of cr as signed integers. Return
+// 0 if there is none.
+static unsigned getNarrowBitwidth(const ConstantRange &cr, unsigned bitwidth) {
+  if (cr.isFullSet() || cr.isEmptySet()) {
+    return 0;
+  }
+  for (unsigned narrow : {8, 16, 32}) {
+    if (narrow >= bitwidth) {
+      break;
+    }
+    if (cr.getSignedMin().getMinSignedBits() <= narrow &&
+	cr.getSignedMax().getMinSignedBits() <= narrow) {
+      return narrow;
+    }
+  }
+  return 0;
+}
+
+// An induction cycle (header phi, increment and the comparisons that
+// use them) that can be computed in a smaller type.
+struct NarrowInductionCycle {
+  PHINode *phi;
+  BinaryOperator *inc;
+  ConstantInt *step;
+  unsigned bitwidth;
+  // comparisons whose other operand also fits in bitwidth
+  std::vector<ICmpInst *> cmps;
+};
+
+// Decide whether the induction variable PHI of L can be narrowed. The
+// values of the phi at the header and of its increment where it is
+// defined must fit in the smaller type. Then, the phi, the increment
+// and the comparisons between them and values that also fit are
+// computed in the smaller type.
+static llvm::Optional<NarrowInductionCycle>
+getNarrowInductionCycle(ClamGlobalAnalysis &clam, Loop &L, PHINode &PHI) {
+  BasicBlock *header = L.getHeader();
+  BasicBlock *latch = L.getLoopLatch();
+  BasicBlock *preheader = L.getLoopPreheader();
+  IntegerType *ty = dyn_cast<IntegerType>(PHI.getType());
+  if (!latch || !preheader || !ty || ty->getBitWidth() > 64 ||
+      PHI.getNumIncomingValues() != 2 ||
+      PHI.getBasicBlockIndex(preheader) < 0) {
+    return None;
+  }
+  ConstantInt *Step = nullptr;
+  BinaryOperator *Inc = getInductionIncrement(PHI, latch, Step);
+  if (!Inc) {
+    return None;
+  }
+  const bool keep_ghost = false;
+  llvm::Optional<clam_abstract_domain> pre = clam.getPre(header, keep_ghost);
+  if (!pre.hasValue() || pre.getValue().is_bottom()) {
+    return None;
+  }
+  auto cfg_builder_ptr =
+    clam.getCfgBuilderMan().getCfgBuilder(*(header->getParent()));
+  unsigned phiBitwidth = getNarrowBitwidth(
+      getConstantRange(cfg_builder_ptr, pre.getValue(), PHI), ty->getBitWidth());
+  unsigned incBitwidth = getNarrowBitwidth(
+      getConstantRange(clam, *(Inc->getParent()), *Inc), ty->getBitWidth());
+  if (phiBitwidth == 0 || incBitwidth == 0) {
+    return None;
+  }
+  NarrowInductionCycle cycle;
+  cycle.phi = &PHI;
+  cycle.inc = Inc;
+  cycle.step = Step;
+  cycle.bitwidth = std::max(phiBitwidth, incBitwidth);
+  if (Step->getValue().getMinSignedBits() > cycle.bitwidth) {
+    return None;
+  }
+  SmallPtrSet<ICmpInst *, 4> seen;
+  for (Value *v : {static_cast<Value *>(&PHI), static_cast<Value *>(Inc)}) {
+    for (User *U : v->users()) {
+      ICmpInst *Cmp = dyn_cast<ICmpInst>(U);
+      if (!Cmp || !L.contains(Cmp) || !seen.insert(Cmp).second) {
+	continue;
+      }
+      bool narrowable = true;
+      for (Value *op : Cmp->operands()) {
+	if (op == &PHI || op == Inc) {
+	  continue;
+	}
+	ConstantRange opRange = getConstantRange(clam, *(Cmp->getParent()), *op);
+	unsigned opBitwidth = getNarrowBitwidth(opRange, ty->getBitWidth());
+	narrowable &= (opBitwidth != 0 && opBitwidth <= cycle.bitwidth);
+      }
+      if (narrowable) {
+	cycle.cmps.push_back(Cmp);
+      }
+    }
+  }
+  return cycle;
+}
+
+// Rewrite the induction cycle to its new bitwidth. Other users of
+// the phi and the increment use their sign-extended values.
+static void narrowInductionCycle(const NarrowInductionCycle &cycle,
+				 BasicBlock *preheader, BasicBlock *latch) {
+  PHINode *PHI = cycle.phi;
+  BinaryOperator *Inc = cycle.inc;
+  IntegerType *narrowTy = IntegerType::get(PHI->getContext(), cycle.bitwidth);
+  BasicBlock *header = PHI->getParent();
+
+  PHINode *narrowPHI =
+    PHINode::Create(narrowTy, 2, PHI->getName() + ".narrow", &header->front());
+  IRBuilder<> Builder(preheader->getTerminator());
+  Value *narrowInit =
+    Builder.CreateTrunc(PHI->getIncomingValueForBlock(preheader), narrowTy);
+
+  Builder.SetInsertPoint(Inc);
+  Value *narrowStep = ConstantInt::get(narrowTy, cycle.step->getSExtValue(), true);
+  Value *op0 = (Inc->getOperand(0) == PHI ? narrowPHI : narrowStep);
+  Value *op1 = (Inc->getOperand(1) == PHI ? narrowPHI : narrowStep);
+  BinaryOperator *narrowInc = cast<BinaryOperator>(Builder.CreateBinOp(
+      Inc->getOpcode(), op0, op1, Inc->getName() + ".narrow"));
+  // the result fits in the smaller type so there is no signed overflow
+  narrowInc->setHasNoSignedWrap(true);
+  narrowPHI->addIncoming(narrowInit, preheader);
+  narrowPHI->addIncoming(narrowInc, latch);
+
+  for (ICmpInst *Cmp : cycle.cmps) {
+    Builder.SetInsertPoint(Cmp);
+    auto getNarrowOperand = [&](Value *op) -> Value * {
+      if (op == PHI) return narrowPHI;
+      if (op == Inc) return narrowInc;
+      return Builder.CreateTrunc(op, narrowTy);
+    };
+    Value *narrowCmp =
+      Builder.CreateICmp(Cmp->getPredicate(), getNarrowOperand(Cmp->getOperand(0)),
+			 getNarrowOperand(Cmp->getOperand(1)), Cmp->getName());
+    Cmp->replaceAllUsesWith(narrowCmp);
+    Cmp->eraseFromParent();
+  }
+
+  // The rest of users use the wide values
+  Builder.SetInsertPoint(header, header->getFirstInsertionPt());
+  Value *widePHI = Builder.CreateSExt(narrowPHI, PHI->getType(), PHI->getName());
+  Builder.SetInsertPoint(narrowInc->getNextNode());
+  Value *wideInc = Builder.CreateSExt(narrowInc, Inc->getType(), Inc->getName());
+  Inc->replaceAllUsesWith(wideInc);
+  Inc->eraseFromParent();
+  PHI->replaceAllUsesWith(widePHI);
+  PHI->eraseFromParent();
+  RecursivelyDeleteTriviallyDeadInstructions(widePHI);
+  RecursivelyDeleteTriviallyDeadInstructions(wideInc);
+  NumNarrowedInductionCycles++;
+}
+
+// Narrow the induction cycles of all loops of F. The increments of
+// the narrowed cycles are removed from narrowed.
+static bool narrowInductionCycles(ClamGlobalAnalysis &clam, LoopInfo &LI,
+				  std::vector<std::pair<BinaryOperator *, unsigned>> &narrowed) {
+  // All cycles are chosen before rewriting any because the Crab CFG
+  // refers to the original instructions.
+  std::vector<std::pair<Loop *, NarrowInductionCycle>> cycles;
+  for (Loop *L : LI.getLoopsInPreorder()) {
+    for (PHINode &PHI : L->getHeader()->phis()) {
+      if (auto cycle = getNarrowInductionCycle(clam, *L, PHI)) {
+	cycles.push_back({L, cycle.getValue()});
+      }
+    }
+  }
+  if (cycles.empty()) {
+    return false;
+  }
+  SmallPtrSet<BinaryOperator *, 8> incs;
+  DenseMap<ICmpInst *, unsigned> numCycles;
+  for (auto &kv : cycles) {
+    incs.insert(kv.second.inc);
+    for (ICmpInst *Cmp : kv.second.cmps) {
+      numCycles[Cmp]++;
+    }
+  }
+  // A comparison between two narrowed cycles keeps the wide values
+  for (auto &kv : cycles) {
+    auto &cmps = kv.second.cmps;
+    cmps.erase(std::remove_if(cmps.begin(), cmps.end(),
+			      [&numCycles](ICmpInst *Cmp) {
+				return numCycles[Cmp] > 1;
+			      }),
+	       cmps.end());
+  }
+  narrowed.erase(std::remove_if(narrowed.begin(), narrowed.end(),
+				[&incs](const std::pair<BinaryOperator *, unsigned> &kv) {
+				  return incs.count(kv.first) > 0;
+				}),
+		 narrowed.end());
+  for (auto &kv : cycles) {
+    narrowInductionCycle(kv.second, kv.first->getLoopPreheader(),
+			 kv.first->getLoopLatch());
+  }
+  return true;
+}
+
+// A bound of the number of times the header of a loop is executed,
+// given by the interval [lb, ub] of the induction variable iv at the
+// header.
+struct LoopTripCount {
+  uint64_t count;
+  // count is the number of times the header is executed, not only an
+  // upper bound
+  bool exact;
+  PHINode *iv;
+  int64_t lb;
+  int64_t ub;
+};
+
+// Return whether the header of L is always executed tripCount times.
+// This is the case if L has a single exit and iv starts at one end of
+// its interval at the header and leaves the loop at the other end.
+static bool isExactTripCount(ClamGlobalAnalysis &clam, Loop &L,
+			     const LoopTripCount &tc, int64_t step) {
+  BasicBlock *preheader = L.getLoopPreheader();
+  BasicBlock *exiting = L.getExitingBlock();
+  BasicBlock *exit = L.getExitBlock();
+  if (!preheader || !exiting || !exit || !exit->getSinglePredecessor()) {
+    return false;
+  }
+  ConstantInt *init =
+    dyn_cast<ConstantInt>(tc.iv->getIncomingValueForBlock(preheader));
+  if (!init || init->getBitWidth() > 64 ||
+      init->getSExtValue() != (step > 0 ? tc.lb : tc.ub)) {
+    return false;
+  }
+  const bool keep_ghost = false;
+  llvm::Optional<clam_abstract_domain> pre = clam.getPre(exit, keep_ghost);
+  if (!pre.hasValue() || pre.getValue().is_bottom()) {
+    return false;
+  }
+  auto cfg_builder_ptr =
+    clam.getCfgBuilderMan().getCfgBuilder(*(exit->getParent()));
+  ConstantRange exitRange =
+    getConstantRange(cfg_builder_ptr, pre.getValue(), *tc.iv);
+  const APInt *last = exitRange.getSingleElement();
+  return last && last->getSExtValue() == (step > 0 ? tc.ub : tc.lb);
+}
+
+// Return an upper bound of the number of times the header of L is
+// executed. The bound is given by any induction variable (a header
+// phi incremented by a constant in the latch) whose interval at the
+// header is finite: it takes a different value at each iteration.
+static llvm::Optional<LoopTripCount> getMaxTripCount(ClamGlobalAnalysis &clam,
+						     Loop &L) {
+  BasicBlock *header = L.getHeader();
+  BasicBlock *latch = L.getLoopLatch();
+  if (!latch) {
+    return None;
+  }
+  const bool keep_ghost = false;
+  llvm::Optional<clam_abstract_domain> pre = clam.getPre(header, keep_ghost);
+  if (!pre.hasValue() || pre.getValue().is_bottom()) {
+    return None;
+  }
+  auto cfg_builder_ptr =
+    clam.getCfgBuilderMan().getCfgBuilder(*(header->getParent()));
+  llvm::Optional<LoopTripCount> res;
+  for (PHINode &PHI : header->phis()) {
+    if (!PHI.getType()->isIntegerTy() ||
+	PHI.getType()->getIntegerBitWidth() > 64) {
+      continue;
+    }
+    ConstantInt *Step = nullptr;
+    if (!getInductionIncrement(PHI, latch, Step)) {
+      continue;
+    }
+    ConstantRange range = getConstantRange(cfg_builder_ptr, pre.getValue(), PHI);
+    if (range.isFullSet() || range.isEmptySet()) {
+      continue;
+    }
+    int64_t lb = range.getSignedMin().getSExtValue();
+    int64_t ub = range.getSignedMax().getSExtValue();
+    uint64_t step = Step->getValue().abs().getZExtValue();
+    uint64_t count = (((uint64_t)ub - (uint64_t)lb) / step) + 1;
+    if (count == 0 /* overflow */) {
+      continue;
+    }
+    LoopTripCount tc{count, false, &PHI, lb, ub};
+    tc.exact = isExactTripCount(clam, L, tc, Step->getSExtValue());
+    if (!res.hasValue() || tc.exact ||
+	(!res.getValue().exact && tc.count < res.getValue().count)) {
+      res = tc;
+    }
+  }
+  return res;
+}
+
+// Clamp the loop-invariant bound n of the exit conditions of L that
+// compare tc.iv with n. tc.iv is in [tc.lb, tc.ub] wherever it is
+// used in L so, for instance, iv < n is equivalent to
+// iv < smin(n, ub + 1). SCEV bounds the backedge-taken count of L
+// with the clamped bound but it ignores assumptions about tc.iv.
+static void clampExitBounds(Loop &L, const LoopTripCount &tc) {
+  BasicBlock *preheader = L.getLoopPreheader();
+  if (!preheader) {
+    return;
+  }
+  IntegerType *ty = cast<IntegerType>(tc.iv->getType());
+  APInt lb(ty->getBitWidth(), tc.lb, true);
+  APInt ub(ty->getBitWidth(), tc.ub, true);
+  SmallVector<BasicBlock *, 4> exitings;
+  L.getExitingBlocks(exitings);
+  for (BasicBlock *exiting : exitings) {
+    BranchInst *BI = dyn_cast<BranchInst>(exiting->getTerminator());
+    if (!BI || !BI->isConditional()) {
+      continue;
+    }
+    ICmpInst *Cmp = dyn_cast<ICmpInst>(BI->getCondition());
+    if (!Cmp || !L.contains(Cmp)) {
+      continue;
+    }
+    // Normalize the comparison to iv pred n
+    unsigned boundIdx = 1;
+    ICmpInst::Predicate pred = Cmp->getPredicate();
+    if (Cmp->getOperand(1) == tc.iv) {
+      boundIdx = 0;
+      pred = ICmpInst::getSwappedPredicate(pred);
+    } else if (Cmp->getOperand(0) != tc.iv) {
+      continue;
+    }
+    Value *bound = Cmp->getOperand(boundIdx);
+    if (isa<Constant>(bound) || !L.isLoopInvariant(bound)) {
+      continue;
+    }
+    // bound is replaced with select(bound keepPred C, bound, C)
+    ICmpInst::Predicate keepPred;
+    APInt C;
+    switch (pred) {
+    case ICmpInst::ICMP_SLT:
+      if (ub.isMaxSignedValue()) continue;
+      keepPred = ICmpInst::ICMP_SLT; C = ub + 1;
+      break;
+    case ICmpInst::ICMP_SLE:
+      keepPred = ICmpInst::ICMP_SLT; C = ub;
+      break;
+    case ICmpInst::ICMP_SGT:
+      if (lb.isMinSignedValue()) continue;
+      keepPred = ICmpInst::ICMP_SGT; C = lb - 1;
+      break;
+    case ICmpInst::ICMP_SGE:
+      keepPred = ICmpInst::ICMP_SGT; C = lb;
+      break;
+    case ICmpInst::ICMP_ULT:
+      // [lb, ub] is also the unsigned interval of iv
+      if (lb.isNegative()) continue;
+      keepPred = ICmpInst::ICMP_ULT; C = ub + 1;
+      break;
+    case ICmpInst::ICMP_ULE:
+      if (lb.isNegative()) continue;
+      keepPred = ICmpInst::ICMP_ULT; C = ub;
+      break;
+    default:
+      continue;
+    }
+    IRBuilder<> Builder(preheader->getTerminator());
+    Constant *CV = ConstantInt::get(ty, C);
+    Value *keep = Builder.CreateICmp(keepPred, bound, CV, "crab_exit_bound_cmp");
+    Value *clamped = Builder.CreateSelect(keep, bound, CV, "crab_exit_bound");
+    Cmp->setOperand(boundIdx, clamped);
+    NumClampedExitBounds++;
+  }
+}
+
+// Assume the interval of the induction variable at the header and,
+// unless integers are narrowed, clamp the bounds of the exit
+// conditions so that SCEV can bound the loop. The narrowed
+// comparisons truncate their operands and a clamped bound might not
+// fit in the smaller type. Only if the trip count is exact and the
+// exiting block has no profile data then add branch weights so that
+// LLVM's estimated trip count (used by the unroller and the
+// vectorizer) is the trip count.
+static void setMaxTripCount(Loop &L, const LoopTripCount &tc,
+			    bool narrowIntegers) {
+  LLVMContext &ctx = L.getHeader()->getContext();
+  if (!narrowIntegers) {
+    clampExitBounds(L, tc);
+  }
+
+  BasicBlock *header = L.getHeader();
+  IRBuilder<> Builder(header, header->getFirstInsertionPt());
+  Type *ty = tc.iv->getType();
+  Builder.CreateAssumption(
+      Builder.CreateICmpSGE(tc.iv, ConstantInt::get(ty, tc.lb, true)));
+  Builder.CreateAssumption(
+      Builder.CreateICmpSLE(tc.iv, ConstantInt::get(ty, tc.ub, true)));
+
+  if (!tc.exact) {
+    return;
+  }
+  BasicBlock *exiting = L.getExitingBlock();
+  BranchInst *BI = dyn_cast<BranchInst>(exiting->getTerminator());
+  if (!BI || !BI->isConditional() || BI->getMetadata(LLVMContext::MD_prof)) {
+    return;
+  }
+  // The exiting branch is executed count times and leaves the loop
+  // only once.
+  uint32_t stayWeight =
+    (uint32_t)std::min<uint64_t>(tc.count - 1,
+				 std::numeric_limits<uint32_t>::max());
+  uint32_t exitWeight = 1;
+  MDBuilder MDB(ctx);
+  if (L.contains(BI->getSuccessor(0))) {
+    BI->setMetadata(LLVMContext::MD_prof,
+		    MDB.createBranchWeights(stayWeight, exitWeight));
+  } else {
+    BI->setMetadata(LLVMContext::MD_prof,
+		    MDB.createBranchWeights(exitWeight, stayWeight));
+  }
+  NumExactLoopTripCounts++;
+}
+
+// Decide which comparisons of B can be folded and the range of the
+// condition of B's switch, if any. Conditions used only by B's
+// terminator are evaluated at the exit of B. Otherwise, they are
+// evaluated using the ranges of their operands where they are defined.
+static void markFoldableConditions(ClamGlobalAnalysis &clam, BasicBlock &B,
+				   std::vector<std::pair<WeakVH, Constant *>> &cmps,
+				   std::vector<std::pair<WeakVH, ConstantRange>> &switches) {
+  llvm::Optional<clam_abstract_domain> post = clam.getPost(&B, false);
+  if (!post.hasValue() || post.getValue().is_bottom()) {
+    return;
+  }
+  auto cfg_builder_ptr = clam.getCfgBuilderMan().getCfgBuilder(*(B.getParent()));
+  Instruction *TI = B.getTerminator();
+  for (Instruction &I : B) {
+    ICmpInst *CmpI = dyn_cast<ICmpInst>(&I);
+    if (!CmpI || !CmpI->getOperand(0)->getType()->isIntegerTy() ||
+	(isa<Constant>(CmpI->getOperand(0)) &&
+	 isa<Constant>(CmpI->getOperand(1)))) {
+      continue;
+    }
+    bool onlyUsedByTerminator =
+      std::all_of(CmpI->user_begin(), CmpI->user_end(),
+		  [TI](const User *U) { return U == TI; });
+    Constant *C = nullptr;
+    if (onlyUsedByTerminator) {
+      C = foldICmp(*CmpI,
+		   getConstantRange(cfg_builder_ptr, post.getValue(),
+				    *(CmpI->getOperand(0))),
+		   getConstantRange(cfg_builder_ptr, post.getValue(),
+				    *(CmpI->getOperand(1))));
+    } else {
+      C = foldICmp(*CmpI, getConstantRange(clam, B, *(CmpI->getOperand(0))),
+		   getConstantRange(clam, B, *(CmpI->getOperand(1))));
+    }
+    if (C) {
+      cmps.push_back({WeakVH(CmpI), C});
+    }
+  }
+  if (SwitchInst *SI = dyn_cast<SwitchInst>(TI)) {
+    ConstantRange r =
+      getConstantRange(cfg_builder_ptr, post.getValue(), *(SI->getCondition()));
+    if (!r.isFullSet()) {
+      switches.push_back({WeakVH(SI), r});
+    }
+  }
+}
+
+// Replace CmpI with C. Selects and branches on CmpI are folded.
+static void foldCmp(ICmpInst *CmpI, Constant *C) {
+  ++NumFoldedCmps;
+  SmallSetVector<SelectInst *, 4> Selects;
+  SmallSetVector<BasicBlock *, 4> Branches;
+  for (User *U : CmpI->users()) {
+    if (SelectInst *SelI = dyn_cast<SelectInst>(U)) {
+      if (SelI->getCondition() == CmpI) {
+	Selects.insert(SelI);
+      }
+    } else if (BranchInst *BI = dyn_cast<BranchInst>(U)) {
+      Branches.insert(BI->getParent());
+    }
+  }
+  CmpI->replaceAllUsesWith(C);
+  CmpI->eraseFromParent();
+  for (SelectInst *SelI : Selects) {
+    SelI->replaceAllUsesWith(C->isOneValue() ? SelI->getTrueValue()
+			                     : SelI->getFalseValue());
+    SelI->eraseFromParent();
+  }
+  for (BasicBlock *BB : Branches) {
+    ConstantFoldTerminator(BB);
+  }
+}
+
+// Remove the cases of SI that are not in r. The default destination
+// becomes unreachable if the remaining cases cover r.
+static void foldSwitch(SwitchInst *SI, const ConstantRange &r) {
+  BasicBlock *BB = SI->getParent();
+  LLVMContext &ctx = BB->getContext();
+  {
+    SwitchInstProfUpdateWrapper SIW(*SI);
+    for (auto it = SI->case_begin(); it != SI->case_end();) {
+      if (r.contains(it->getCaseValue()->getValue())) {
+	++it;
+      } else {
+	++NumFoldedCases;
+	it->getCaseSuccessor()->removePredecessor(BB);
+	it = SIW.removeCase(it);
+      }
+    }
+  }
+  BasicBlock *Default = SI->getDefaultDest();
+  if (SI->getNumCases() > 0 &&
+      r.getSetSize().getLimitedValue() == SI->getNumCases() &&
+      !isa<UnreachableInst>(Default->getFirstNonPHIOrDbg())) {
+    BasicBlock *Unreachable =
+      BasicBlock::Create(ctx, "crab_default_unreachable", BB->getParent(), Default);
+    new UnreachableInst(ctx, Unreachable);
+    Default->removePredecessor(BB);
+    SI->setDefaultDest(Unreachable);
+  }
+  if (const APInt *value = r.getSingleElement()) {
+    SI->setCondition(ConstantInt::get(SI->getCondition()->getType(), *value));
+  }
+  ConstantFoldTerminator(BB);
+}
+
 // Identify whether B is dead and which B's successor edges are dead.
 static bool markDeadBlocksAndEdges(ClamGlobalAnalysis  &clam,
 				   BasicBlock &B,
@@ -581,7 +1955,12 @@ Optimizer::Optimizer(ClamGlobalAnalysis  &clam,
 		     std::function<llvm::LoopInfo*(llvm::Function*)> LI,
 		     InvariantsLocation addInvariants,
 		     bool removeDeadCode,
-		     bool replaceWithConstants)
+		     bool replaceWithConstants,
+		     bool addRangeMetadata,
+		     bool lowerChecks,
+		     bool narrowIntegers,
+		     bool loopTripCount,
+		     bool foldConditions)
   : m_clam(clam)
   , m_cg(callgraph)
   , m_dt(DT)
@@ -589,13 +1968,24 @@ Optimizer::Optimizer(ClamGlobalAnalysis  &clam,
   , m_invLoc(addInvariants)
   , m_removeDeadCode(removeDeadCode)
   , m_replaceWithConstants(replaceWithConstants)
-  , m_assumeFn(nullptr) {}
+  , m_addRangeMetadata(addRangeMetadata)
+  , m_lowerChecks(lowerChecks)
+  , m_narrowIntegers(narrowIntegers)
+  , m_loopTripCount(loopTripCount)
+  , m_foldConditions(foldConditions)
+  , m_assumeFn(nullptr)
+  , m_trapFn(nullptr) {}
 
   
 bool Optimizer::runOnModule(Module &M) {
   if (m_invLoc == InvariantsLocation::NONE &&
       !m_removeDeadCode &&
-      !m_replaceWithConstants) {
+      !m_replaceWithConstants &&
+      !m_addRangeMetadata &&
+      !m_lowerChecks &&
+      !m_narrowIntegers &&
+      !m_loopTripCount &&
+      !m_foldConditions) {
     return false;
   }
 
@@ -612,6 +2002,12 @@ bool Optimizer::runOnModule(Module &M) {
   if (m_cg) {
     m_cg->getOrInsertFunction(m_assumeFn);
   }
+  if (m_lowerChecks) {
+    m_trapFn = Intrinsic::getDeclaration(&M, Intrinsic::trap);
+    if (m_cg) {
+      m_cg->getOrInsertFunction(m_trapFn);
+    }
+  }
   
   bool change = false;
   for (auto &f : M) {
@@ -642,7 +2038,21 @@ bool Optimizer::runOnFunction(Function &F) {
   LLVMContext &ctx = F.getContext();
   std::vector<BasicBlock *> DeadBlocks;
   std::vector<std::pair<BasicBlock *, BasicBlock *>> DeadEdges;
+  // instrumented checks and whether they are proven safe
+  std::vector<std::pair<WeakVH, bool>> Checks;
+  // operations that can be narrowed and their new bitwidth
+  std::vector<std::pair<BinaryOperator *, unsigned>> Narrowed;
+  // comparisons and switches that can be folded
+  std::vector<std::pair<WeakVH, Constant *>> FoldedCmps;
+  std::vector<std::pair<WeakVH, ConstantRange>> FoldedSwitches;
   bool change = false;  
+
+  if (m_invLoc == InvariantsLocation::BLOCK ||
+      m_invLoc == InvariantsLocation::LOOP_HEADER || 
+      m_invLoc == InvariantsLocation::ALL) {
+    change |= instrumentBlocks(F, dt);
+  }
+  
   for (auto &B : F) {
     if (hasUnreachable(B)) {
       continue;
@@ -657,51 +2067,100 @@ bool Optimizer::runOnFunction(Function &F) {
       continue;
     }
     
-    if (m_invLoc == InvariantsLocation::BLOCK ||
-	m_invLoc == InvariantsLocation::LOOP_HEADER || 
-	m_invLoc == InvariantsLocation::ALL) {
+    if ((m_invLoc == InvariantsLocation::LOAD_INST ||
+	 m_invLoc == InvariantsLocation::ALL) && readMemory(B)) {
+      auto cfg_builder_ptr = m_clam.getCfgBuilderMan().getCfgBuilder(F);
+      // Use the invariants stored by the analysis if any. Otherwise,
+      // replay the Crab block from its entry.
+      llvm::Optional<bool> stored = instrumentLoadInstFromStored(
+          m_clam, B, cfg_builder_ptr, m_cg, m_assumeFn);
+      if (stored.hasValue()) {
+	change |= stored.getValue();
+      } else {
+	const bool keep_ghost = true;
+	llvm::Optional<clam_abstract_domain> pre = m_clam.getPre(&B, keep_ghost);
+	if (pre.hasValue()) {
+	  basic_block_label_t bb_label = cfg_builder_ptr->getCrabBasicBlock(&B);
+	  change |= instrumentLoadInst(pre.getValue(), cfg.get_node(bb_label),
+				       F.getContext(), m_cg, m_assumeFn);
+	}
+      }
+    }
+
+    if (m_replaceWithConstants) {
       const bool keep_ghost = false;
       llvm::Optional<clam_abstract_domain> pre = m_clam.getPre(&B, keep_ghost);
       if (pre.hasValue()) {
-	if (m_invLoc == InvariantsLocation::BLOCK ||
-	    m_invLoc == InvariantsLocation::ALL) {
-	  auto csts = pre.getValue().to_linear_constraint_system();
-	  change |= instrumentBlock(csts, &B, F.getContext(), m_cg, dt, m_assumeFn);
-	} else {
-	  assert(m_invLoc == InvariantsLocation::LOOP_HEADER);
-	  LoopInfo *LI = m_li(&F); // it can be nullptr
-	  if (LI && LI->isLoopHeader(&B)) {
-	    auto csts = pre.getValue().to_linear_constraint_system();
-	    change |= instrumentBlock(csts, &B, F.getContext(), m_cg, dt, m_assumeFn);
-	  }
-	}
+	auto cfg_builder_ptr = m_clam.getCfgBuilderMan().getCfgBuilder(F);	
+	basic_block_label_t bb_label = cfg_builder_ptr->getCrabBasicBlock(&B);
+	change |= constantReplacement(cfg_builder_ptr, pre.getValue(), cfg.get_node(bb_label));
       }
     }
-    
-    if ((m_invLoc == InvariantsLocation::LOAD_INST ||
-	 m_invLoc == InvariantsLocation::ALL) && readMemory(B)) {
+
+    if (m_addRangeMetadata) {
+      const bool keep_ghost = false;
+      llvm::Optional<clam_abstract_domain> pre = m_clam.getPre(&B, keep_ghost);
+      if (pre.hasValue() && readMemory(B)) {
+	auto cfg_builder_ptr = m_clam.getCfgBuilderMan().getCfgBuilder(F);
+	basic_block_label_t bb_label = cfg_builder_ptr->getCrabBasicBlock(&B);
+	change |= addLoadRangeMetadata(cfg_builder_ptr, pre.getValue(),
+				       cfg.get_node(bb_label));
+      }
+      change |= addCallRangeMetadata(B);
+    }
+
+    if (m_lowerChecks) {
       const bool keep_ghost = true;
       llvm::Optional<clam_abstract_domain> pre = m_clam.getPre(&B, keep_ghost);
+      auto cfg_builder_ptr = m_clam.getCfgBuilderMan().getCfgBuilder(F);
       if (pre.hasValue()) {
-	auto cfg_builder_ptr = m_clam.getCfgBuilderMan().getCfgBuilder(F);
 	basic_block_label_t bb_label = cfg_builder_ptr->getCrabBasicBlock(&B);
-	change |= instrumentLoadInst(pre.getValue(), cfg.get_node(bb_label),
-				     F.getContext(), m_cg, m_assumeFn);
+	CollectChecks CC(cfg_builder_ptr, Checks);
+	CC.run(pre.getValue(), cfg.get_node(bb_label));
       }
     }
 
-    if (m_replaceWithConstants) {
+    if (m_narrowIntegers) {
       const bool keep_ghost = false;
       llvm::Optional<clam_abstract_domain> pre = m_clam.getPre(&B, keep_ghost);
       if (pre.hasValue()) {
-	auto cfg_builder_ptr = m_clam.getCfgBuilderMan().getCfgBuilder(F);	
+	auto cfg_builder_ptr = m_clam.getCfgBuilderMan().getCfgBuilder(F);
 	basic_block_label_t bb_label = cfg_builder_ptr->getCrabBasicBlock(&B);
-	change |= constantReplacement(cfg_builder_ptr, pre.getValue(), cfg.get_node(bb_label));
+	markNarrowIntegers(cfg_builder_ptr, pre.getValue(),
+			   cfg.get_node(bb_label), Narrowed);
       }
     }
+
+    if (m_foldConditions) {
+      markFoldableConditions(m_clam, B, FoldedCmps, FoldedSwitches);
+    }
+  }
+
+  if (m_loopTripCount) {
+    // Before narrowing integers because it rewrites the increments
+    // of induction variables.
+    if (LoopInfo *LI = m_li(&F)) {
+      for (Loop *L : LI->getLoopsInPreorder()) {
+	if (llvm::Optional<LoopTripCount> tc = getMaxTripCount(m_clam, *L)) {
+	  setMaxTripCount(*L, tc.getValue(), m_narrowIntegers);
+	  NumLoopTripCounts++;
+	  change = true;
+	}
+      }
+    }
+  }
+  
+  // Rewrite the narrowed operations once all blocks have been
+  // processed because the Crab CFG refers to the original ones.
+  if (m_narrowIntegers) {
+    if (LoopInfo *LI = m_li(&F)) {
+      change |= narrowInductionCycles(m_clam, *LI, Narrowed);
+    }
   }
+  narrowIntegers(F, Narrowed);
+  change |= !Narrowed.empty();
 
-  change = (!DeadEdges.empty() || !DeadBlocks.empty());
+  change |= (!DeadEdges.empty() || !DeadBlocks.empty());
   
   // The actual removal of edges and blocks
   while (!DeadEdges.empty()) {
@@ -717,6 +2176,64 @@ bool Optimizer::runOnFunction(Function &F) {
     removeDeadBlock(B, ctx);
   }
 
+  // Comparisons in dead blocks have been already replaced with undef
+  for (auto &kv : FoldedCmps) {
+    if (ICmpInst *CmpI = dyn_cast_or_null<ICmpInst>(kv.first)) {
+      foldCmp(CmpI, kv.second);
+      change = true;
+    }
+  }
+  for (auto &kv : FoldedSwitches) {
+    if (SwitchInst *SI = dyn_cast_or_null<SwitchInst>(kv.first)) {
+      foldSwitch(SI, kv.second);
+      change = true;
+    }
+  }
+  
+  if (m_lowerChecks) {
+    // Checks in dead blocks have been already removed
+    SmallPtrSet<Instruction *, 16> ProvenSafe;
+    for (auto &kv : Checks) {
+      if (kv.first && kv.second) {
+	ProvenSafe.insert(cast<Instruction>(kv.first));
+      }
+    }
+    // Checks that Crab could not prove or that were not translated
+    // (e.g., the CFG was simplified) are lowered to runtime checks.
+    std::vector<CallInst *> ChecksToLower, ChecksToRemove;
+    for (auto &I : instructions(F)) {
+      if (isInstrumentedCheck(I)) {
+	if (ProvenSafe.count(&I)) {
+	  ChecksToRemove.push_back(cast<CallInst>(&I));
+	} else {
+	  ChecksToLower.push_back(cast<CallInst>(&I));
+	}
+      }
+    }
+    for (CallInst *CI : ChecksToRemove) {
+      removeCheck(CI, m_cg);
+      NumSafeChecks++;
+    }
+    for (CallInst *CI : ChecksToLower) {
+      if (hasCrabOnlyCondition(*CI)) {
+	// No runtime provides the Crab intrinsics so the check is
+	// left unhardened.
+	std::string loc;
+	if (const DebugLoc &DL = CI->getDebugLoc()) {
+	  loc = " at line " + std::to_string(DL.getLine());
+	}
+	CLAM_WARNING("unproven check in " << F.getName().str() << loc
+		     << " cannot be lowered to a runtime check and it is removed");
+	removeCheck(CI, m_cg);
+	NumUnhardenedChecks++;
+      } else {
+	lowerCheckToTrap(CI, m_trapFn, m_cg);
+	NumRuntimeChecks++;
+      }
+    }
+    change |= (!ChecksToRemove.empty() || !ChecksToLower.empty());
+  }
+  
   CRAB_VERBOSE_IF(1, crab::get_msg_stream()
 		  << "Finished clam optimizer for " << F.getName().str() << ".\n";);
   return change;
@@ -730,7 +2247,12 @@ OptimizerPass::OptimizerPass():
 bool OptimizerPass::runOnModule(Module &M) {
   if (InvLoc == InvariantsLocation::NONE &&
       !RemoveDeadCode &&
-      !ReplaceWithConstants) {
+      !ReplaceWithConstants &&
+      !AddRangeMetadata &&
+      !LowerChecks &&
+      !NarrowIntegers &&
+      !LoopTripCount &&
+      !FoldConditions) {
     return false;
   }
   
@@ -742,6 +2264,12 @@ bool OptimizerPass::runOnModule(Module &M) {
 
   // Get clam
   ClamPass &clam = getAnalysis<ClamPass>();
+  const AnalysisParams &params = clam.getAnalysisParams();
+  if (params.stream_functions && !params.run_inter) {
+    CLAM_ERROR("the optimizer cannot be used with --crab-stream-functions "
+	       "because the invariants are released after each function "
+	       "is analyzed");
+  }
 
   // Collect all the dominator tree and loop info in maps
   DenseMap<Function*, DominatorTree*> dt_map;
@@ -750,7 +2278,7 @@ bool OptimizerPass::runOnModule(Module &M) {
     if (F.empty()) continue;
     if (requireDominatorTree(InvLoc))
       dt_map[&F] = &(getAnalysis<DominatorTreeWrapperPass>(F).getDomTree());
-    if (requireLoopInfo(InvLoc))    
+    if (requireLoopInfo(InvLoc) || LoopTripCount || NarrowIntegers)
       li_map[&F] = &(getAnalysis<LoopInfoWrapperPass>(F).getLoopInfo());
   }
 
@@ -763,7 +2291,9 @@ bool OptimizerPass::runOnModule(Module &M) {
 			       auto it = li_map.find(F);
 			       return (it != li_map.end() ? it->second : nullptr);
 			     },
-			     InvLoc, RemoveDeadCode, ReplaceWithConstants));
+			     InvLoc, RemoveDeadCode, ReplaceWithConstants,
+			     AddRangeMetadata, LowerChecks, NarrowIntegers,
+			     LoopTripCount, FoldConditions));
   return m_impl->runOnModule(M);
 }
 
@@ -775,7 +2305,7 @@ void OptimizerPass::getAnalysisUsage(AnalysisUsage &AU) const {
   if (requireDominatorTree(InvLoc)) {
     AU.addRequired<DominatorTreeWrapperPass>();
   }
-  if (requireLoopInfo(InvLoc)) {
+  if (requireLoopInfo(InvLoc) || LoopTripCount || NarrowIntegers) {
     AU.addRequired<LoopInfoWrapperPass>();
   }
 }
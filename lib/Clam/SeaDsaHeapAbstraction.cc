@@ -292,6 +292,43 @@ void SeaDsaHeapAbstraction::computeReadModNewNodesFromCallSite(
       << "}\n";);
 }
 
+// Return v1 \ v2 by keeping the same ordering in v1.
+// Precondition: v1 and v2 can have duplicates. Each occurrence in v2
+// removes the first remaining occurrence in v1.
+//
+// e.g., [1,3,3,4] \ [1,3] = [3,4]
+// e.g., [1,3,3,3,4,5] \ [1,3,3] = [3,4,5]
+//
+// Region ids are dense so counters is indexed by region id. It must
+// contain only zeros and it is left that way on return.
+static SeaDsaHeapAbstraction::RegionVec
+stable_difference(const SeaDsaHeapAbstraction::RegionVec &v1,
+                  const SeaDsaHeapAbstraction::RegionVec &v2,
+                  std::vector<unsigned> &counters) {
+  for (auto const &rgn : v2) {
+    if (rgn.getId() >= counters.size()) {
+      counters.resize(rgn.getId() + 1, 0);
+    }
+    counters[rgn.getId()]++;
+  }
+  SeaDsaHeapAbstraction::RegionVec out;
+  out.reserve(v1.size());
+  for (auto const &rgn : v1) {
+    if (rgn.getId() < counters.size() && counters[rgn.getId()] > 0) {
+      // found: skip one occurrence
+      counters[rgn.getId()]--;
+    } else {
+      // not found
+      out.push_back(rgn);
+    }
+  }
+  // reset the counters of the regions from v2 not found in v1
+  for (auto const &rgn : v2) {
+    counters[rgn.getId()] = 0;
+  }
+  return out;
+}
+
 // Pre-compute all the information per function and callsites
 void SeaDsaHeapAbstraction::initialize(const llvm::Module &M) {
 
@@ -341,6 +378,10 @@ void SeaDsaHeapAbstraction::initialize(const llvm::Module &M) {
     }
   }
 
+  // Region ids are dense so we can use a vector of counters to
+  // compute the read-only regions.
+  std::vector<unsigned> counters(m_max_id, 0);
+
   /// Sanity check: compatibility check between function regions and
   /// all its callsites' regions. The check should always pass. Note
   /// that whether two region's types are compatible is defined by
@@ -434,9 +475,11 @@ void SeaDsaHeapAbstraction::initialize(const llvm::Module &M) {
       }
     }
 
-    m_func_accessed[&F] = readsF_out;
-    m_func_mods[&F] = modsF_out;
-    m_func_news[&F] = newsF_out;
+    m_func_only_reads[&F] =
+        stable_difference(readsF_out, modsF_out, counters);
+    m_func_accessed[&F] = std::move(readsF_out);
+    m_func_mods[&F] = std::move(modsF_out);
+    m_func_news[&F] = std::move(newsF_out);
 
     while (!FCalls.empty()) {
       const CallInst *CI = FCalls.back();
@@ -461,7 +504,8 @@ void SeaDsaHeapAbstraction::initialize(const llvm::Module &M) {
         }
       }
 
-      m_callsite_accessed[CI] = readsC_out;
+      m_callsite_only_reads[CI] =
+          stable_difference(readsC_out, modsC_out, counters);
       m_callsite_mods[CI] = modsC_out;
       m_callsite_news[CI] = newsC_out;
       CRAB_LOG(
@@ -608,67 +652,40 @@ const llvm::Value *SeaDsaHeapAbstraction::getSingleton(RegionId region) const {
   return nullptr;
 }
 
-// Return v1 \ v2 by keeping the same ordering in v1.
-// Precondition: v1 can have duplicates but v2 cannot.
-//
-// e.g., [1,3,3,4] \ [1,3] = [3,4]
-// e.g., [1,3,3,3,4,5] \ [1,3,3] = [3,4,5]
-static SeaDsaHeapAbstraction::RegionVec
-stable_difference(SeaDsaHeapAbstraction::RegionVec &v1,
-                  SeaDsaHeapAbstraction::RegionVec &v2) {
-  // v1 and v2 can be modified because we pass copies
-
-  std::sort(v2.begin(), v2.end());
-  SeaDsaHeapAbstraction::RegionVec out;
-  out.reserve(v1.size());
-  for (auto rgn : v1) {
-    auto lower = std::lower_bound(v2.begin(), v2.end(), rgn);
-    if (lower != v2.end() && rgn == *lower) {
-      // found
-      //
-      // remove from v2 so we handle correctly duplicates
-      // FIXME: do not use erase, it's expensive
-      v2.erase(lower);
-    } else if (lower == v2.end() || rgn < *lower) {
-      // not found
-      out.push_back(rgn);
-    }
-  }
-  return out;
-}
-
-SeaDsaHeapAbstraction::RegionVec
+const SeaDsaHeapAbstraction::RegionVec &
 SeaDsaHeapAbstraction::getOnlyReadRegions(const llvm::Function &fn) {
-  RegionVec v1 = m_func_accessed[&fn];
-  RegionVec v2 = m_func_mods[&fn];
-  return stable_difference(v1, v2);
+  auto it = m_func_only_reads.find(&fn);
+  return (it != m_func_only_reads.end() ? it->second : m_empty);
 }
 
-SeaDsaHeapAbstraction::RegionVec
+const SeaDsaHeapAbstraction::RegionVec &
 SeaDsaHeapAbstraction::getModifiedRegions(const llvm::Function &fn) {
-  return m_func_mods[&fn];
+  auto it = m_func_mods.find(&fn);
+  return (it != m_func_mods.end() ? it->second : m_empty);
 }
 
-SeaDsaHeapAbstraction::RegionVec
+const SeaDsaHeapAbstraction::RegionVec &
 SeaDsaHeapAbstraction::getNewRegions(const llvm::Function &fn) {
-  return m_func_news[&fn];
+  auto it = m_func_news.find(&fn);
+  return (it != m_func_news.end() ? it->second : m_empty);
 }
 
-SeaDsaHeapAbstraction::RegionVec
+const SeaDsaHeapAbstraction::RegionVec &
 SeaDsaHeapAbstraction::getOnlyReadRegions(const llvm::CallInst &I) {
-  RegionVec v1 = m_callsite_accessed[&I];
-  RegionVec v2 = m_callsite_mods[&I];
-  return stable_difference(v1, v2);
+  auto it = m_callsite_only_reads.find(&I);
+  return (it != m_callsite_only_reads.end() ? it->second : m_empty);
 }
 
-SeaDsaHeapAbstraction::RegionVec
+const SeaDsaHeapAbstraction::RegionVec &
 SeaDsaHeapAbstraction::getModifiedRegions(const llvm::CallInst &I) {
-  return m_callsite_mods[&I];
+  auto it = m_callsite_mods.find(&I);
+  return (it != m_callsite_mods.end() ? it->second : m_empty);
 }
 
-SeaDsaHeapAbstraction::RegionVec
+const SeaDsaHeapAbstraction::RegionVec &
 SeaDsaHeapAbstraction::getNewRegions(const llvm::CallInst &I) {
-  return m_callsite_news[&I];
+  auto it = m_callsite_news.find(&I);
+  return (it != m_callsite_news.end() ? it->second : m_empty);
 }
 
 } // namespace clam
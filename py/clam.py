@@ -252,8 +252,11 @@ def parseArgs(argv):
     p.add_argument('--disable-lower-constant-expr',
                     help='Disable lowering of constant expressions to instructions',
                     dest='disable_lower_cst_expr', default=False, action='store_true')
+    p.add_argument('--lower-switch',
+                    help='Lower switch instructions (they are translated directly otherwise)',
+                    dest='lower_switch', default=False, action='store_true')
     p.add_argument('--disable-lower-switch',
-                    help='Disable lowering of switch instructions',
+                    help='Deprecated: switch instructions are only lowered with --lower-switch',
                     dest='disable_lower_switch', default=False, action='store_true')
     p.add_argument('--devirt-functions',
                     help="Resolve indirect calls (needed for soundness):\n"
@@ -287,6 +290,15 @@ def parseArgs(argv):
     p.add_argument('--crab-cfg-simplify',
                     help='Perform some crab CFG transformations',
                     dest='crab_cfg_simplify', default=False, action='store_true')
+    p.add_argument('--crab-minimize-phi-copies',
+                    help='Translate PHI nodes with the minimal number of copies and temporaries',
+                    dest='crab_minimize_phi_copies', default=False, action='store_true')
+    p.add_argument('--crab-fold-edge-blocks',
+                    help='Do not create a block for an edge if its destination has a single predecessor',
+                    dest='crab_fold_edge_blocks', default=False, action='store_true')
+    p.add_argument('--crab-max-global-init-table-size',
+                    help='Initialize larger constant integer tables only with their bounds (0 means no limit)',
+                    dest='crab_max_global_init_table_size', type=int, default=0)
     p.add_argument('--crab-dom',
                     help="Choose abstract domain:\n"
                           "- int: intervals\n"
@@ -365,6 +377,11 @@ def parseArgs(argv):
                              'dce',
                              'add-invariants',
                              'replace-with-constants',
+                             'add-range-metadata',
+                             'lower-checks',
+                             'narrow-integers',
+                             'loop-trip-count',
+                             'fold-conditions',
                              'all'],
                     dest='crab_optimizer', default='none')
     p.add_argument('--crab-opt-invariants-loc',
@@ -378,6 +395,18 @@ def parseArgs(argv):
     add_bool_argument(p, 'crab-preserve-invariants',
                       help='Preserve invariants for queries after analysis has finished',
                       dest='store_invariants', default=True)
+    p.add_argument('--crab-store-stmt-invariants',
+                    help='Preserve invariants after some statements: load,gep,call,marked (comma-separated)',
+                    dest='store_stmt_invariants', default=None)
+    p.add_argument('--crab-export-ranges',
+                    help='Write the ranges of all integer values to a file',
+                    dest='crab_export_ranges', default=None, metavar='FILE')
+    p.add_argument('--crab-stream-functions',
+                    help='Intra-procedural analysis: release the CFG and invariants of each function after it is analyzed (the crab variables are kept)',
+                    dest='crab_stream_functions', default=False, action='store_true')
+    p.add_argument('--crab-aa',
+                    help='Run GVN after the analysis using Clam regions and tags as alias analysis',
+                    dest='crab_aa', default=False, action='store_true')
     p.add_argument('--crab-promote-assume',
                     help='Promote verifier.assume calls to llvm.assume intrinsics',
                     dest='crab_promote_assume', default=False, action='store_true')
@@ -441,10 +470,16 @@ def parseArgs(argv):
     # Choose between own crab way of naming values and instnamer
     add_bool_argument(p, 'crab-name-values', default=True,
                       help=a.SUPPRESS, dest='crab_name_values')
+    # Do not name values: names are generated only for printing
+    p.add_argument('--crab-skip-name-values', default=False,
+                   help=a.SUPPRESS, dest='crab_skip_name_values', action='store_true')
     add_bool_argument(p, 'crab-keep-shadows', default=False,
                       help=a.SUPPRESS, dest='crab_keep_shadows')
     add_bool_argument(p, 'crab-enable-bignums', default=False,
                       help=a.SUPPRESS, dest='crab_enable_bignums')
+    # Run ClamAnalysis and a pipeline with the new pass manager
+    p.add_argument('--clam-new-pm-pipeline', default=None,
+                   help=a.SUPPRESS, dest='clam_new_pm_pipeline')
     #### END CRAB
 
     args = p.parse_args(argv)
@@ -455,6 +490,14 @@ def parseArgs(argv):
     if args.machine != 32 and args.machine != 64:
         p.error("Unknown option -m%s" % args.machine)
 
+    if args.crab_optimizer == 'lower-checks' and args.assert_check == 'uaf':
+        p.error("--crab-opt=lower-checks cannot be used with --crab-check=uaf: "
+                "use-after-free checks cannot be lowered to runtime checks")
+
+    if args.crab_stream_functions and args.crab_optimizer != 'none':
+        p.error("--crab-stream-functions cannot be used with --crab-opt: "
+                "invariants are released after each function is analyzed")
+
     return args
 
 def createWorkDir(dname = None, save = False):
@@ -739,8 +782,8 @@ def crabpp(in_name, out_name, args, extra_args=[], cpu = -1, mem = -1):
         crabpp_args.append('--scalarize-load-store=true')
     if args.disable_lower_cst_expr:
         crabpp_args.append('--crab-lower-constant-expr=false')
-    if args.disable_lower_switch:
-        crabpp_args.append('--crab-lower-switch=false')
+    if args.lower_switch and not args.disable_lower_switch:
+        crabpp_args.append('--crab-lower-switch=true')
 
     # Postponed until clam is run, otherwise it can be undone by the optLlvm
     # if args.lower_unsigned_icmp:
@@ -797,8 +840,8 @@ def clam(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
         clam_args.append('--crab-lower-select')
     if args.disable_lower_cst_expr:
         clam_args.append('--crab-lower-constant-expr=false')
-    if args.disable_lower_switch:
-        clam_args.append('--crab-lower-switch=false')
+    if args.lower_switch and not args.disable_lower_switch:
+        clam_args.append('--crab-lower-switch=true')
 
     clam_args.append('--crab-dom={0}'.format(args.crab_dom))
     clam_args.append('--crab-widening-delay={0}'.format(args.widening_delay))
@@ -851,6 +894,16 @@ def clam(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
             clam_args.append('--crab-opt-dce')
         if args.crab_optimizer == 'replace-with-constants' or args.crab_optimizer == 'all':
             clam_args.append('--crab-opt-replace-with-constants')
+        if args.crab_optimizer == 'add-range-metadata' or args.crab_optimizer == 'all':
+            clam_args.append('--crab-opt-add-range-metadata')
+        if args.crab_optimizer == 'lower-checks':
+            clam_args.append('--crab-opt-lower-checks')
+        if args.crab_optimizer == 'narrow-integers' or args.crab_optimizer == 'all':
+            clam_args.append('--crab-opt-narrow-integers')
+        if args.crab_optimizer == 'loop-trip-count' or args.crab_optimizer == 'all':
+            clam_args.append('--crab-opt-loop-trip-count')
+        if args.crab_optimizer == 'fold-conditions' or args.crab_optimizer == 'all':
+            clam_args.append('--crab-opt-fold-conditions')
         if args.crab_optimizer == 'add-invariants' or args.crab_optimizer == 'all':
             clam_args.append('--crab-opt-add-invariants={0}'.format(args.crab_optimizer_inv_loc))
 
@@ -883,6 +936,10 @@ def clam(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
         clam_args.append('--crab-enable-warnings=false')
     if args.crab_sanity_checks: clam_args.append('--crab-sanity-checks')
     if args.crab_cfg_simplify: clam_args.append('--crab-cfg-simplify')
+    if args.crab_minimize_phi_copies: clam_args.append('--crab-minimize-phi-copies')
+    if args.crab_fold_edge_blocks: clam_args.append('--crab-fold-edge-blocks')
+    if args.crab_max_global_init_table_size > 0:
+        clam_args.append('--crab-max-global-init-table-size={0}'.format(args.crab_max_global_init_table_size))
     if args.crab_print_invariants:
         clam_args.append('--crab-print-invariants=true')
     else:
@@ -891,6 +948,14 @@ def clam(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
         clam_args.append('--crab-store-invariants=true')
     else:
         clam_args.append('--crab-store-invariants=false')
+    if args.store_stmt_invariants:
+        clam_args.append('--crab-store-stmt-invariants={0}'.format(args.store_stmt_invariants))
+    if args.crab_export_ranges:
+        clam_args.append('--crab-export-ranges={0}'.format(args.crab_export_ranges))
+    if args.crab_stream_functions:
+        clam_args.append('--crab-stream-functions')
+    if args.crab_aa:
+        clam_args.append('--crab-aa')
     if args.crab_dot_cfg:
         clam_args.append('--crab-dot-cfg=true')
     else:
@@ -904,10 +969,14 @@ def clam(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
         clam_args.append('--crab-name-values=true')
     else:
         clam_args.append('--crab-name-values=false')
+    if args.crab_skip_name_values:
+        clam_args.append('--crab-skip-name-values')
     if args.crab_enable_bignums:
         clam_args.append('--crab-enable-bignums=true')
     else:
         clam_args.append('--crab-enable-bignums=false')
+    if args.clam_new_pm_pipeline:
+        clam_args.append('--clam-new-pm-pipeline={0}'.format(args.clam_new_pm_pipeline))
     # end hidden options
 
     if verbose:
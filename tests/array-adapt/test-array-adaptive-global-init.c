@@ -0,0 +1,39 @@
+// RUN: %clam -O0 --crab-inter --crab-track=sing-mem --crab-dom=int --crab-check=assert --crab-sanity-checks --lower-unsigned-icmp "%s" 2>&1 | OutputCheck %s
+// CHECK: ^4  Number of total safe checks$
+// CHECK: ^0  Number of total warning checks$
+
+#include <stdint.h>
+
+extern int nd(void);
+extern void __CRAB_assert(int);
+extern void __CRAB_assume(int);
+
+// The initializers of these tables are translated into a few range
+// stores instead of one store per element.
+const int32_t table1[256] = {
+  [0 ... 127] = 3, [128 ... 255] = 9
+};
+
+int32_t table2[512];
+
+int32_t lookup1(const int32_t *t) {
+  int i = nd();
+  __CRAB_assume(i >= 0 && i < 256);
+  return t[i];
+}
+
+int32_t lookup2(const int32_t *t) {
+  int i = nd();
+  __CRAB_assume(i >= 0 && i < 512);
+  return t[i];
+}
+
+int main() {
+  int32_t x = lookup1(table1);
+  __CRAB_assert(x >= 3);
+  __CRAB_assert(x <= 9);
+  int32_t y = lookup2(table2);
+  __CRAB_assert(y >= 0);
+  __CRAB_assert(y <= 0);
+  return x + y;
+}
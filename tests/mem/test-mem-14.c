@@ -0,0 +1,47 @@
+// RUN: %clam -O0 --crab-dom=int --crab-track=mem --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %clam -O0 -m64 --crab-dom=int --crab-track=mem --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^4  Number of total safe checks$
+// CHECK: ^0  Number of total warning checks$
+
+/**
+ * Each access to a field of an array of structs is a single GEP with
+ * an array index followed by a struct field index. Field indices are
+ * always i32 while array indices are i32 with -m32 (j is truncated)
+ * and i64 with -m64 (i and k are extended) so the second run
+ * translates GEPs whose indices have different widths.
+ **/
+
+extern void __CRAB_assert(int);
+extern void __CRAB_assume(int);
+extern int int_nd(void);
+extern long long long_nd(void);
+
+struct pair {
+  int x;
+  long long y;
+};
+
+struct pair arr[8];
+
+int main() {
+  int i = int_nd();
+  long long j = long_nd();
+  unsigned char k = (unsigned char)int_nd();
+  __CRAB_assume(i >= 0);
+  __CRAB_assume(i < 8);
+  __CRAB_assume(j >= 0);
+  __CRAB_assume(j < 8);
+  __CRAB_assume(k < 8);
+
+  arr[i].x = 1;
+  arr[j].y = 2;
+  arr[k].x = arr[i].x;
+
+  int x = arr[k].x;
+  long long y = arr[i].y;
+  __CRAB_assert(x >= 0);
+  __CRAB_assert(x <= 1);
+  __CRAB_assert(y >= 0);
+  __CRAB_assert(y <= 2);
+  return 0;
+}
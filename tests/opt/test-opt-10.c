@@ -0,0 +1,16 @@
+extern void __CRAB_assume(int);
+extern int int_nd(void);
+
+int a[10];
+
+int main() {
+  int i;
+  for (i = 0; i < 10; i++) {
+    a[i] = i;
+  }
+  int j = int_nd();
+  __CRAB_assume(j >= 0);
+  __CRAB_assume(j < 10);
+  int x = a[j];
+  return x;
+}
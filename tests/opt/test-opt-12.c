@@ -0,0 +1,29 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+extern int int_nd(void);
+extern void sink(int *);
+
+/* seadsa */
+extern void sea_dsa_set_modified(const void *p);
+
+/* Tag analysis */
+typedef uint64_t tag_t;
+extern void __CRAB_intrinsic_add_tag(void *, tag_t);
+#define ADD_TAG(PTR, TAG)             \
+  __CRAB_intrinsic_add_tag(PTR, TAG); \
+  sea_dsa_set_modified(PTR);
+
+int main() {
+  int *a = (int *)malloc(sizeof(int) * 4);
+  int *b = (int *)malloc(sizeof(int) * 4);
+  ADD_TAG(a, 1);
+  ADD_TAG(b, 2);
+  // a and b are in the same region
+  sink(int_nd() ? a : b);
+  int *x = &a[1];
+  int *y = &b[1];
+  *x = 1;
+  *y = 2;
+  return *x;
+}
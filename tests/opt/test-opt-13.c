@@ -0,0 +1,14 @@
+#include <stdlib.h>
+
+// p and q point to different regions
+__attribute__((noinline)) int foo(int *p, int *q) {
+  *p = 1;
+  *q = 2;
+  return *p;
+}
+
+int main() {
+  int *a = (int *)malloc(sizeof(int) * 4);
+  int *b = (int *)malloc(sizeof(int) * 4);
+  return foo(a, b);
+}
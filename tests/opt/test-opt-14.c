@@ -0,0 +1,15 @@
+extern void __CRAB_assume(int);
+extern int int_nd(void);
+
+int a[10];
+
+int main() {
+  int n = int_nd();
+  __CRAB_assume(n >= 0);
+  __CRAB_assume(n <= 10);
+  int i;
+  for (i = 0; i < n; i++) {
+    a[i] = i;
+  }
+  return a[0];
+}
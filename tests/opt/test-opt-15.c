@@ -0,0 +1,18 @@
+extern void __CRAB_assume(int);
+extern int int_nd(void);
+extern void marker1(void);
+extern void marker2(void);
+
+int main() {
+  int x = int_nd();
+  int y = int_nd();
+  int z = int_nd();
+  __CRAB_assume(z >= 1000);
+  if (x <= y) {
+    marker1();
+    if (y <= x) {
+      marker2();
+    }
+  }
+  return z;
+}
@@ -0,0 +1,22 @@
+extern void __CRAB_assume(int);
+extern int int_nd(void);
+
+int a[10];
+
+int clamp(int x) {
+  if (x < 0) return 0;
+  if (x > 100) return 100;
+  return x;
+}
+
+int main() {
+  int i;
+  for (i = 0; i < 10; i++) {
+    a[i] = i;
+  }
+  int j = int_nd();
+  __CRAB_assume(j >= 0);
+  __CRAB_assume(j < 10);
+  int k = clamp(int_nd());
+  return a[j] + k;
+}
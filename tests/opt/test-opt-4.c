@@ -0,0 +1,17 @@
+extern int int_nd(void);
+
+int foo(int *p) {
+  return *p;
+}
+
+int bar(int *q) {
+  if (q) {
+    return *q;
+  }
+  return 0;
+}
+
+int main() {
+  int x = int_nd();
+  return foo(&x) + bar(&x);
+}
@@ -0,0 +1,13 @@
+extern void __CRAB_assume(int);
+extern long long int_nd(void);
+
+long long foo(void) {
+  long long x = int_nd();
+  __CRAB_assume(x >= 0);
+  __CRAB_assume(x < 100);
+  return x * 3 + 1;
+}
+
+int main() {
+  return (int) foo();
+}
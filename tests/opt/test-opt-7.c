@@ -0,0 +1,16 @@
+extern void __CRAB_assume(int);
+extern int int_nd(void);
+
+int a[10];
+
+int main() {
+  int n = int_nd();
+  __CRAB_assume(n >= 0);
+  __CRAB_assume(n < 5);
+  if (n < 10) {
+    a[n] = 1;
+  } else {
+    a[0] = 2;
+  }
+  return a[n];
+}
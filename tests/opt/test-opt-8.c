@@ -0,0 +1,19 @@
+extern void __CRAB_assume(int);
+extern long long int_nd(void);
+
+int a[100];
+
+void foo(void) {
+  long long n = int_nd();
+  __CRAB_assume(n >= 0);
+  __CRAB_assume(n <= 100);
+  long long i;
+  for (i = 0; i < n; i++) {
+    a[i] = 0;
+  }
+}
+
+int main() {
+  foo();
+  return a[0];
+}
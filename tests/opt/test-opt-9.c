@@ -0,0 +1,9 @@
+int a[10];
+
+int main() {
+  int i;
+  for (i = 0; i < 10; i++) {
+    a[i] = i;
+  }
+  return a[0];
+}
@@ -0,0 +1,25 @@
+// RUN: %clam -O0 --crab-dom=int --crab-export-ranges=%t.ranges "%s" 2>&1
+// RUN: cat %t.ranges | OutputCheck %s
+// RUN: %clam -O0 --crab-dom=int --crab-stream-functions --crab-export-ranges=%t.stream.ranges "%s" 2>&1
+// RUN: cat %t.stream.ranges | OutputCheck %s
+// CHECK: ^foo [0-9]+ 11 15$
+// CHECK: ^main [0-9]+ 0 198$
+
+extern int nd(void);
+extern void __CRAB_assume(int);
+
+// Each line of the exported file is <function> <value id> <lo> <hi>
+int foo(int x) {
+  __CRAB_assume(x >= 1);
+  __CRAB_assume(x <= 5);
+  int y = x + 10;
+  return y;
+}
+
+int main() {
+  int a = foo(nd());
+  int b = nd();
+  __CRAB_assume(b >= 0);
+  __CRAB_assume(b < 100);
+  return a + b * 2;
+}
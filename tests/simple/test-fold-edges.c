@@ -0,0 +1,28 @@
+// RUN: %clam -O0 --crab-dom=int --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %clam -O0 --crab-dom=int --crab-fold-edge-blocks --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^3  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern int nd(void);
+extern void __CRAB_assert(int);
+
+// The then blocks have a single predecessor so their incoming edges
+// are folded. The innermost one is unreachable: its folded edge is
+// infeasible.
+int main() {
+  int x = nd();
+  int y = 0;
+  if (x > 0) {
+    y = x;
+    __CRAB_assert(y >= 1);
+  }
+  if (x > 5) {
+    if (x < 3) {
+      __CRAB_assert(x > 100);
+      y = -1;
+    }
+  }
+  __CRAB_assert(y >= 0);
+  return y;
+}
@@ -0,0 +1,32 @@
+// RUN: %clam -O0 --crab-dom=int --crab-print-invariants=false --crab-disable-warnings --clam-new-pm-pipeline="require<clam>,function(instsimplify),print<clam>" "%s" 2>&1 | OutputCheck %s
+// CHECK: ^Function foo: re-analyzed$
+// CHECK: ^  ret \[11, 15\]$
+// CHECK: ^Function bar: kept$
+// CHECK: ^  ret \[1, 6\]$
+
+extern int nd(void);
+extern void __CRAB_assume(int);
+
+int a[10];
+
+// clam lowers the constant GEP of the store into an instruction that
+// instsimplify folds back so only foo (and main) are modified.
+int foo(int x) {
+  __CRAB_assume(x >= 1);
+  __CRAB_assume(x <= 5);
+  a[2] = x;
+  return x + 10;
+}
+
+int bar(int x) {
+  __CRAB_assume(x >= 0);
+  __CRAB_assume(x <= 5);
+  return x + 1;
+}
+
+int main() {
+  int i = nd();
+  __CRAB_assume(i >= 0);
+  __CRAB_assume(i < 10);
+  return foo(nd()) + bar(nd()) + a[i];
+}
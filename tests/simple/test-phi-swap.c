@@ -0,0 +1,37 @@
+// RUN: %clam -O0 --crab-dom=zones --crab-widening-delay=3 --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %clam -O0 --crab-dom=zones --crab-widening-delay=3 --crab-minimize-phi-copies --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^7  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern int nd(void);
+extern void __CRAB_assert(int);
+
+// The PHI nodes of the loop header swap x and y and rotate a, b and
+// c so their parallel copies need temporaries.
+int main() {
+  int x = 1;
+  int y = 2;
+  int a = 1;
+  int b = 2;
+  int c = 3;
+  int i;
+  int n = nd();
+  for (i = 0; i < n; i++) {
+    int t = x;
+    x = y;
+    y = t;
+    int u = a;
+    a = b;
+    b = c;
+    c = u;
+  }
+  __CRAB_assert(x >= 1);
+  __CRAB_assert(x <= 2);
+  __CRAB_assert(y >= 1);
+  __CRAB_assert(y <= 2);
+  __CRAB_assert(a >= 1);
+  __CRAB_assert(b <= 3);
+  __CRAB_assert(c >= 1);
+  return 0;
+}
@@ -0,0 +1,38 @@
+// RUN: %clam -O0 --crab-dom=int --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %clam -O0 --crab-dom=int --crab-check=assert --crab-sanity-checks --crab-stream-functions "%s" 2>&1 | OutputCheck %s
+// CHECK: ^3  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^1  Number of total warning checks$
+
+// The checks of each function are kept when its CFG and invariants
+// are released so the counts are the same with and without streaming.
+
+extern void __CRAB_assume(int);
+extern void __CRAB_assert(int);
+extern int int_nd(void);
+
+int foo(int x) {
+  __CRAB_assume(x >= 0);
+  __CRAB_assume(x <= 10);
+  int y = x + 5;
+  __CRAB_assert(y >= 5);
+  return y;
+}
+
+int bar(int a) {
+  int i, s = 0;
+  for (i = 0; i < 10; i++) {
+    s++;
+  }
+  __CRAB_assert(s == 10);
+  __CRAB_assert(a > 0);
+  return s + a;
+}
+
+int main() {
+  int x = int_nd();
+  int r = foo(x) + bar(x);
+  int k = 7;
+  __CRAB_assert(k <= 7);
+  return r;
+}
@@ -0,0 +1,37 @@
+// RUN: %clam -O0 --crab-dom=int --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %clam -O0 --lower-switch --crab-dom=int --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %clam -O0 --crab-inter --crab-dom=int --crab-check=assert --crab-sanity-checks --crab-store-invariants=true "%s" 2>&1 | OutputCheck %s
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern int nd(void);
+extern void __CRAB_assert(int);
+
+// The same checks are proven with and without lowering the switch.
+// The first destination is reached by non-contiguous cases so its
+// edge has one crab block per range. The invariants of those blocks
+// are stored by the intra-procedural (default) and inter-procedural
+// analyses.
+int main() {
+  int v = nd();
+  int x;
+  switch (v) {
+  case 1:
+  case 3:
+  case 4:
+  case 8:
+    __CRAB_assert(v >= 1);
+    __CRAB_assert(v <= 8);
+    x = v;
+    break;
+  case 2:
+    __CRAB_assert(v == 2);
+    x = 2;
+    break;
+  default:
+    x = 0;
+  }
+  __CRAB_assert(x >= 0);
+  __CRAB_assert(x <= 8);
+  return x;
+}
@@ -82,7 +82,7 @@ static llvm::cl::opt<bool>
 static llvm::cl::opt<bool>
     LowerSwitch("crab-lower-switch",
                 llvm::cl::desc("Lower switch instructions"),
-                llvm::cl::init(true));
+                llvm::cl::init(false));
 
 static llvm::cl::opt<bool>
     LowerSelect("crab-lower-select",
@@ -12,6 +12,7 @@
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/InitializePasses.h"
 #include "llvm/LinkAllPasses.h"
+#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
@@ -78,7 +79,7 @@ static llvm::cl::opt<bool>
 static llvm::cl::opt<bool>
     LowerSwitch("crab-lower-switch",
                 llvm::cl::desc("Lower switch instructions"),
-                llvm::cl::init(true));
+                llvm::cl::init(false));
 
 static llvm::cl::opt<bool>
     LowerSelect("crab-lower-select",
@@ -90,6 +91,12 @@ static llvm::cl::opt<bool>
 	    llvm::cl::desc("Optimize LLVM bitcode by using invariants"),
 	    llvm::cl::init(false));
 
+static llvm::cl::opt<bool> ClamAA(
+    "crab-aa",
+    llvm::cl::desc("Run GVN after the analysis using Clam regions and tags "
+                   "as alias analysis"),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<bool> PromoteAssume(
     "crab-promote-assume",
     llvm::cl::desc("Promote verifier.assume to llvm.assume intrinsics"),
@@ -110,9 +117,54 @@ static llvm::cl::opt<bool>
              llvm::cl::desc("Add checks for use-after-free errors"),
              llvm::cl::init(false));
 
+static llvm::cl::opt<std::string> NewPMPipeline(
+    "clam-new-pm-pipeline",
+    llvm::cl::desc("Run ClamAnalysis with the new pass manager instead of "
+                   "ClamPass. The pipeline can use require<clam> and "
+                   "print<clam> (e.g., "
+                   "\"require<clam>,function(instsimplify),print<clam>\")"),
+    llvm::cl::init(""), llvm::cl::value_desc("pipeline"), llvm::cl::Hidden);
+
 
 using namespace clam;
 
+// run the new pass manager pipeline NewPMPipeline on M
+static bool runNewPMPipeline(llvm::Module &M) {
+  llvm::PassBuilder PB;
+  llvm::LoopAnalysisManager LAM;
+  llvm::FunctionAnalysisManager FAM;
+  llvm::CGSCCAnalysisManager CGAM;
+  llvm::ModuleAnalysisManager MAM;
+  MAM.registerPass([] { return ClamAnalysis(); });
+  FAM.registerPass([] { return ClamFunctionAnalysis(); });
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+  PB.registerPipelineParsingCallback(
+      [](llvm::StringRef Name, llvm::ModulePassManager &MPM,
+         llvm::ArrayRef<llvm::PassBuilder::PipelineElement>) {
+        if (Name == "require<clam>") {
+          MPM.addPass(llvm::RequireAnalysisPass<ClamAnalysis, llvm::Module>());
+          return true;
+        }
+        if (Name == "print<clam>") {
+          MPM.addPass(ClamPrinterPass(llvm::outs()));
+          return true;
+        }
+        return false;
+      });
+
+  llvm::ModulePassManager MPM;
+  if (auto Err = PB.parsePassPipeline(MPM, NewPMPipeline)) {
+    llvm::errs() << "error: " << llvm::toString(std::move(Err)) << "\n";
+    return false;
+  }
+  MPM.run(M, MAM);
+  return true;
+}
+
 // removes extension from filename if there is one
 std::string getFileName(const std::string &str) {
   std::string filename = str;
@@ -284,7 +336,18 @@ int main(int argc, char **argv) {
     if (UafCheck)
       pass_manager.add(clam::createUseAfterFreeCheckPass());
     /// -- run the crab analyzer
-    pass_manager.add(new clam::ClamPass());
+    if (NewPMPipeline.empty()) {
+      if (ClamAA) {
+        // -- keep the results of ClamPass for LLVM alias analysis
+        pass_manager.add(clam::createClamAAWrapperPass());
+        pass_manager.add(clam::createClamExternalAAWrapperPass());
+      }
+      pass_manager.add(new clam::ClamPass());
+      if (ClamAA) {
+        // -- remove redundant loads using Clam alias analysis
+        pass_manager.add(llvm::createGVNPass());
+      }
+    }
     if (DotLLVMCFG)
       pass_manager.add(createAnnotatedCFGPrinterPass());
   }
@@ -293,7 +356,7 @@ int main(int argc, char **argv) {
     pass_manager.add(createPrintModulePass(asmOutput->os()));
   }
 
-  if (!DisableCrab && CrabOpt) {
+  if (!DisableCrab && CrabOpt && NewPMPipeline.empty()) {
     // post-processing of the bitcode using Crab invariants
     pass_manager.add(clam::createOptimizerPass());
 
@@ -311,7 +374,7 @@ int main(int argc, char **argv) {
     }
   }
 
-  if (!OutputFilename.empty()) {
+  if (!OutputFilename.empty() && NewPMPipeline.empty()) {
     if (OutputAssembly)
       pass_manager.add(createPrintModulePass(output->os()));
     else
@@ -320,6 +383,17 @@ int main(int argc, char **argv) {
 
   pass_manager.run(*module.get());
 
+  if (!DisableCrab && !NewPMPipeline.empty()) {
+    if (!runNewPMPipeline(*module.get()))
+      return 3;
+    if (!OutputFilename.empty()) {
+      if (OutputAssembly)
+        module->print(output->os(), nullptr);
+      else
+        llvm::WriteBitcodeToFile(*module.get(), output->os());
+    }
+  }
+
   if (!AsmOutputFilename.empty())
     asmOutput->keep();
   if (!OutputFilename.empty())